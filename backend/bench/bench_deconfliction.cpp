@@ -0,0 +1,128 @@
+// Deconfliction time for a fleet of raster print paths: four vehicles on
+// adjacent 1 m-leg lawnmower patterns (25k legs each) plus one crossing
+// diagonally through them, 5 m separation. A smaller instance is checked
+// against an all-pairs search.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "deconfliction.h"
+
+namespace {
+
+constexpr double kSeparation = 5.0;
+constexpr double kSpeed = 2.0;
+
+std::vector<PathSegment> raster(uint32_t vehicle, double x0, size_t legs) {
+    // 40 m lanes, 1 m apart, flown back and forth at 1 m steps.
+    std::vector<PathSegment> segments;
+    double t = 0.0;
+    Vec3 from{x0, 0.0, 10.0};
+    for (size_t i = 0; i < legs; ++i) {
+        size_t step = i % 41;
+        size_t lane = i / 41;
+        Vec3 to = from;
+        if (step == 40) {
+            to.y += 1.0;
+        } else {
+            to.x = x0 + ((lane % 2) ? 40.0 - step - 1 : step + 1.0);
+        }
+        double length = std::sqrt((to.x - from.x) * (to.x - from.x) + (to.y - from.y) * (to.y - from.y));
+        segments.push_back({vehicle, static_cast<uint32_t>(i), t, t + length / kSpeed, from, to});
+        t += length / kSpeed;
+        from = to;
+    }
+    return segments;
+}
+
+std::vector<PathSegment> crossing(uint32_t vehicle, size_t legs) {
+    std::vector<PathSegment> segments;
+    double t = 0.0;
+    for (size_t i = 0; i < legs; ++i) {
+        Vec3 from{-20.0 + i * 0.1, static_cast<double>(i) * 0.005, 10.0};
+        Vec3 to{-20.0 + (i + 1) * 0.1, static_cast<double>(i + 1) * 0.005, 10.0};
+        double length = std::sqrt(0.1 * 0.1 + 0.005 * 0.005);
+        segments.push_back({vehicle, static_cast<uint32_t>(i), t, t + length / kSpeed, from, to});
+        t += length / kSpeed;
+    }
+    return segments;
+}
+
+std::vector<PathSegment> fleet(size_t legs) {
+    std::vector<PathSegment> segments;
+    for (uint32_t v = 0; v < 4; ++v) {
+        auto path = raster(v, v * 45.0, legs);
+        segments.insert(segments.end(), path.begin(), path.end());
+    }
+    auto path = crossing(4, legs);
+    segments.insert(segments.end(), path.begin(), path.end());
+    return segments;
+}
+
+// Reference: closest approach of every cross-vehicle pair, sampled finely.
+std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> brute_force(const std::vector<PathSegment>& segments) {
+    std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> pairs;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        for (size_t j = i + 1; j < segments.size(); ++j) {
+            const auto& a = segments[i];
+            const auto& b = segments[j];
+            double start = std::max(a.t0, b.t0);
+            double end = std::min(a.t1, b.t1);
+            if (a.vehicle == b.vehicle || start > end) {
+                continue;
+            }
+            for (int k = 0; k <= 64; ++k) {
+                double t = start + (end - start) * k / 64.0;
+                auto at = [t](const PathSegment& s) {
+                    double f = s.t1 > s.t0 ? (t - s.t0) / (s.t1 - s.t0) : 0.0;
+                    return Vec3{s.p0.x + (s.p1.x - s.p0.x) * f, s.p0.y + (s.p1.y - s.p0.y) * f,
+                                s.p0.z + (s.p1.z - s.p0.z) * f};
+                };
+                Vec3 pa = at(a);
+                Vec3 pb = at(b);
+                double d = std::sqrt((pa.x - pb.x) * (pa.x - pb.x) + (pa.y - pb.y) * (pa.y - pb.y) +
+                                     (pa.z - pb.z) * (pa.z - pb.z));
+                if (d < kSeparation - 1e-6) {
+                    const auto& first = a.vehicle < b.vehicle ? a : b;
+                    const auto& second = a.vehicle < b.vehicle ? b : a;
+                    pairs.emplace(first.vehicle, first.leg, second.vehicle, second.leg);
+                    break;
+                }
+            }
+        }
+    }
+    return pairs;
+}
+
+}
+
+int main() {
+    auto small = fleet(600);
+    auto expected = brute_force(small);
+    auto found = find_conflicts(small, kSeparation, 1 << 20);
+    size_t matched = 0;
+    for (const auto& c : found) {
+        matched += expected.count(std::make_tuple(c.vehicle_a, c.leg_a, c.vehicle_b, c.leg_b));
+    }
+    std::printf("check: %zu legs, %zu conflicting leg pairs, all-pairs found %zu (%zu matched)\n", small.size(),
+                found.size(), expected.size(), matched);
+    if (matched != expected.size()) {
+        std::printf("grid search missed conflicts\n");
+        return 1;
+    }
+
+    auto segments = fleet(25000);
+    auto start = std::chrono::steady_clock::now();
+    auto conflicts = find_conflicts(segments, kSeparation, 1 << 20);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("full: %zu legs (5 vehicles), %zu conflicting leg pairs, %.1f ms\n", segments.size(), conflicts.size(),
+                ms);
+    if (!conflicts.empty()) {
+        std::printf("first: vehicles %u/%u legs %u/%u at t=%.1f s, %.2f m apart\n", conflicts[0].vehicle_a,
+                    conflicts[0].vehicle_b, conflicts[0].leg_a, conflicts[0].leg_b, conflicts[0].time_s,
+                    conflicts[0].distance_m);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Per-client stream bandwidth for a simulated survey flight (8 m/s, slow
+// turns, 50 Hz telemetry) under each /stream encoding, sampled at 10 and
+// 50 Hz. Every delta message is decoded and checked against the binary
+// frame of the same snapshot.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include "delta_stream.h"
+#include "telemetry_frame.h"
+#include "telemetry_store.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kSeconds = 600;
+constexpr int kTelemetryHz = 50;
+constexpr uint32_t kKeyframeInterval = 50;
+
+struct Result {
+    double json_bps = 0.0;
+    double frame_bps = 0.0;
+    double delta_bps = 0.0;
+    double delta_ns = 0.0;
+    bool ok = true;
+};
+
+Result run(int stream_hz) {
+    TelemetryStore store;
+    DeltaEncoder encoder(kKeyframeInterval);
+    DeltaSnapshot decoded;
+    size_t json_bytes = 0;
+    size_t frame_bytes = 0;
+    size_t delta_bytes = 0;
+    std::chrono::steady_clock::duration delta_time{};
+    Result result;
+    double lat = 47.397742;
+    double lon = 8.545594;
+    double heading = 0.0;
+    for (int step = 0; step < kSeconds * kTelemetryHz; ++step) {
+        double t = static_cast<double>(step) / kTelemetryHz;
+        heading = std::fmod(heading + 3.0 / kTelemetryHz, 360.0);
+        double distance = 8.0 / kTelemetryHz;
+        lat += distance * std::cos(heading * kPi / 180.0) / 111320.0;
+        lon += distance * std::sin(heading * kPi / 180.0) / (111320.0 * std::cos(lat * kPi / 180.0));
+        store.position.publish({lat, lon});
+        store.altitude.publish({static_cast<float>(10.0 + 0.5 * std::sin(t / 5.0)), 500.0f});
+        store.heading.publish({heading});
+        store.battery.publish({static_cast<float>(95.0 - t / 20.0), 24.0f});
+        store.mission_progress.publish({static_cast<int>(t / 30.0), kSeconds / 30});
+        if (step % (kTelemetryHz / stream_hz) != 0) {
+            continue;
+        }
+        uint64_t version = store.version();
+        json_bytes += ("data: " + store.state_json(version) + "\n\n").size();
+        auto frame = make_frame(store, version);
+        frame_bytes += kFrameSize;
+
+        auto start = std::chrono::steady_clock::now();
+        std::string message = encoder.next(store);
+        delta_time += std::chrono::steady_clock::now() - start;
+        delta_bytes += message.size();
+        const auto* data = reinterpret_cast<const uint8_t*>(message.data());
+        if (!message.empty() && (!apply_delta(&data, data + message.size(), decoded) ||
+                                 data != reinterpret_cast<const uint8_t*>(message.data()) + message.size())) {
+            result.ok = false;
+        }
+        if (decoded.values[kDeltaLatitude] != frame.latitude_e7 || decoded.values[kDeltaLongitude] != frame.longitude_e7 ||
+            decoded.values[kDeltaAltitude] != frame.altitude_dm || decoded.values[kDeltaHeading] != frame.heading_cdeg ||
+            decoded.values[kDeltaBattery] != frame.battery_percent) {
+            result.ok = false;
+        }
+    }
+    int messages = kSeconds * stream_hz;
+    result.json_bps = static_cast<double>(json_bytes) / kSeconds;
+    result.frame_bps = static_cast<double>(frame_bytes) / kSeconds;
+    result.delta_bps = static_cast<double>(delta_bytes) / kSeconds;
+    result.delta_ns = std::chrono::duration<double, std::nano>(delta_time).count() / messages;
+    return result;
+}
+
+}
+
+int main() {
+    std::printf("%8s %14s %14s %14s %16s\n", "stream", "JSON B/s", "frame B/s", "delta B/s", "delta ns/msg");
+    bool ok = true;
+    for (int hz : {10, 50}) {
+        auto result = run(hz);
+        ok = ok && result.ok;
+        std::printf("%5d Hz %14.0f %14.0f %14.0f %16.1f\n", hz, result.json_bps, result.frame_bps, result.delta_bps,
+                    result.delta_ns);
+    }
+    if (!ok) {
+        std::printf("delta decode mismatch\n");
+        return 1;
+    }
+    return 0;
+}
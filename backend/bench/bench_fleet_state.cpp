@@ -0,0 +1,97 @@
+// Cost of one /fleet/state body for 20 vehicles, full and projected, while a
+// publisher thread updates every vehicle's channels at 50 Hz, as MAVSDK
+// callbacks would. Mirrors fleet_state_json(), which needs live MAVSDK
+// systems, over bare TelemetryStores. Fails if p99 reaches the 1 ms budget.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "telemetry_store.h"
+
+namespace {
+
+constexpr int kVehicles = 20;
+constexpr int kIterations = 20000;
+
+void publish_step(TelemetryStore& store, int vehicle, int i) {
+    store.position.publish({47.3977419 + vehicle * 1e-3 + i * 1e-7, 8.5455938 + i * 2e-7});
+    store.altitude.publish({12.5f + (i % 50) * 0.01f, 500.5f});
+    store.heading.publish({(i % 3600) * 0.1});
+    store.battery.publish({87.0f - (i / 10000), 23.9f});
+    store.mission_progress.publish({i / 1000, 120});
+}
+
+std::string fleet_state(std::vector<std::unique_ptr<TelemetryStore>>& stores, unsigned fields) {
+    std::string json;
+    json.reserve(32 + stores.size() * 480);
+    json += "{ \"vehicles\": [";
+    for (size_t i = 0; i < stores.size(); ++i) {
+        json += i ? ", " : " ";
+        json += "{ \"id\": " + std::to_string(i + 1) + ", \"state\": ";
+        json += stores[i]->state_json(stores[i]->version(), fields);
+        json += " }";
+    }
+    json += " ] }";
+    return json;
+}
+
+struct Result {
+    double p50_us;
+    double p99_us;
+    double max_us;
+    size_t bytes;
+};
+
+Result run(std::vector<std::unique_ptr<TelemetryStore>>& stores, unsigned fields) {
+    std::vector<double> samples;
+    samples.reserve(kIterations);
+    size_t bytes = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        bytes = fleet_state(stores, fields).size();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return {samples[samples.size() / 2], samples[samples.size() * 99 / 100], samples.back(), bytes};
+}
+
+}
+
+int main() {
+    std::vector<std::unique_ptr<TelemetryStore>> stores;
+    for (int v = 0; v < kVehicles; ++v) {
+        stores.push_back(std::make_unique<TelemetryStore>());
+        publish_step(*stores.back(), v, 0);
+    }
+    std::atomic<bool> stop{false};
+    std::thread publisher([&] {
+        for (int i = 1; !stop.load(std::memory_order_relaxed); ++i) {
+            for (int v = 0; v < kVehicles; ++v) {
+                publish_step(*stores[v], v, i);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    });
+
+    unsigned projected = 0;
+    parse_state_fields("position,battery", projected);
+    Result full = run(stores, kStateAllFields);
+    Result slim = run(stores, projected);
+    stop = true;
+    publisher.join();
+
+    std::printf("%d vehicles, publisher running\n", kVehicles);
+    std::printf("%-22s %10s %10s %10s %10s\n", "fields", "bytes", "p50 us", "p99 us", "max us");
+    std::printf("%-22s %10zu %10.1f %10.1f %10.1f\n", "all", full.bytes, full.p50_us, full.p99_us, full.max_us);
+    std::printf("%-22s %10zu %10.1f %10.1f %10.1f\n", "position,battery", slim.bytes, slim.p50_us, slim.p99_us,
+                slim.max_us);
+    if (full.p99_us >= 1000.0 || slim.p99_us >= 1000.0) {
+        std::printf("p99 over the 1 ms budget\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Bytes and CPU per /state snapshot: the JSON body (and its /stream SSE
+// event) against the 19-byte binary frame, with realistic values moving
+// between snapshots. Also checks that a frame decodes back to its input.
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "telemetry_frame.h"
+#include "telemetry_store.h"
+
+namespace {
+
+constexpr int kIterations = 100000;
+
+void publish_step(TelemetryStore& store, int i) {
+    store.position.publish({47.3977419 + i * 1e-7, 8.5455938 + i * 2e-7});
+    store.altitude.publish({12.5f + (i % 50) * 0.01f, 500.5f});
+    store.heading.publish({(i % 3600) * 0.1});
+    store.battery.publish({87.0f - (i / 10000), 23.9f});
+    store.mission_progress.publish({i / 1000, 120});
+}
+
+template <typename F>
+double ns_per_call(TelemetryStore& store, F&& fn) {
+    std::chrono::steady_clock::duration elapsed{};
+    for (int i = 0; i < kIterations; ++i) {
+        publish_step(store, i);
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / kIterations;
+}
+
+}
+
+int main() {
+    TelemetryStore store;
+    size_t json_bytes = 0;
+    double json_ns = ns_per_call(store, [&] {
+        json_bytes += ("data: " + store.state_json(store.version()) + "\n\n").size();
+    });
+    size_t frame_bytes = 0;
+    double frame_ns = ns_per_call(store, [&] {
+        frame_bytes += frame_string(encode_frame(make_frame(store, store.version()))).size();
+    });
+
+    auto frame = make_frame(store, store.version());
+    auto bytes = encode_frame(frame);
+    TelemetryFrame decoded;
+    if (!decode_frame(bytes.data(), bytes.size(), decoded) || decoded.latitude_e7 != frame.latitude_e7 ||
+        decoded.heading_cdeg != frame.heading_cdeg || decoded.seq != frame.seq) {
+        std::printf("frame round trip failed\n");
+        return 1;
+    }
+
+    double json_avg = static_cast<double>(json_bytes) / kIterations;
+    double frame_avg = static_cast<double>(frame_bytes) / kIterations;
+    std::printf("%-22s %10s %12s %14s %14s\n", "encoding", "bytes", "ns/snapshot", "B/s @ 10 Hz", "B/s @ 50 Hz");
+    std::printf("%-22s %10.1f %12.1f %14.0f %14.0f\n", "JSON (SSE event)", json_avg, json_ns, json_avg * 10, json_avg * 50);
+    std::printf("%-22s %10.1f %12.1f %14.0f %14.0f\n", "binary frame", frame_avg, frame_ns, frame_avg * 10, frame_avg * 50);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// G-code import throughput: a synthetic slicer file (perimeter loops with
+// retraction, Z hop and travel between them, 1 mm layers) generated chunk by
+// chunk and streamed through the importer, 256 MB in total. Peak RSS is
+// checked to stay flat, since nothing but the current chunk is held.
+#include <sys/resource.h>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "gcode_import.h"
+
+namespace {
+
+constexpr size_t kTotalBytes = size_t{256} << 20;
+
+long max_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Appends one layer: 40 square loops of 40 extruding moves each.
+void append_layer(std::string& out, size_t layer, double& e) {
+    char line[96];
+    double z = 0.3 + layer * 1.0;
+    for (int loop = 0; loop < 40; ++loop) {
+        double size = 100.0 + loop * 5.0;
+        std::snprintf(line, sizeof(line), "G1 E%.5f F2400 ; retract\nG0 Z%.3f\nG0 X%.3f Y%.3f\nG0 Z%.3f\n",
+                      e - 1.0, z + 1.0, -size / 2, -size / 2, z);
+        out += line;
+        for (int i = 0; i < 40; ++i) {
+            int side = i / 10;
+            double t = (i % 10 + 1) / 10.0 * size;
+            double x = side == 0 ? -size / 2 + t : side == 1 ? size / 2 : side == 2 ? size / 2 - t : -size / 2;
+            double y = side == 0 ? -size / 2 : side == 1 ? -size / 2 + t : side == 2 ? size / 2 : size / 2 - t;
+            e += 0.05 * size / 10.0;
+            std::snprintf(line, sizeof(line), "G1 X%.3f Y%.3f E%.5f\n", x, y, e);
+            out += line;
+        }
+    }
+}
+
+}
+
+int main() {
+    GcodeImportOptions options;
+    options.origin = {47.397742, 8.545594};
+    size_t output_bytes = 0;
+    GcodeImporter importer{options, [&](size_t, const char*, size_t size) { output_bytes += size; }};
+
+    std::string chunk;
+    chunk.reserve(2 << 20);
+    size_t input_bytes = 0;
+    size_t layer = 0;
+    double e = 0.0;
+    double import_s = 0.0;
+    long rss_before = 0;
+    while (input_bytes < kTotalBytes) {
+        chunk.clear();
+        chunk += "G90\nM82\n";
+        while (chunk.size() < (1 << 20)) {
+            append_layer(chunk, layer++, e);
+        }
+        auto start = std::chrono::steady_clock::now();
+        importer.feed(chunk.data(), chunk.size());
+        import_s += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        input_bytes += chunk.size();
+        if (rss_before == 0) {
+            rss_before = max_rss_kb();  // after the first chunk: buffers are warm
+        }
+    }
+    importer.finish();
+    long rss_growth_kb = max_rss_kb() - rss_before;
+    const GcodeImportStats& stats = importer.stats();
+    std::printf("%zu MB G-code, %zu moves -> %zu waypoints in %zu layers, %zu MB CSV\n", input_bytes >> 20,
+                stats.moves, stats.waypoints, stats.layers, output_bytes >> 20);
+    std::printf("import: %.2f s, %.0f MB/s, %.0f ns/move; peak RSS grew %ld kB\n", import_s,
+                input_bytes / 1e6 / import_s, import_s * 1e9 / stats.moves, rss_growth_kb);
+    if (stats.layers != layer || rss_growth_kb > 4096) {
+        std::printf("unexpected layer count or memory growth\n");
+        return 1;
+    }
+    return 0;
+}
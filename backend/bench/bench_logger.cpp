@@ -0,0 +1,92 @@
+// Per-call overhead of the async logger against the synchronous
+// std::cout << ... << std::endl pattern it replaced. Both write to /dev/null
+// so the numbers reflect caller-side cost, not terminal speed.
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "logger.h"
+
+namespace {
+
+constexpr int kIterations = 200000;
+
+template <typename F>
+double ns_per_call(F&& fn, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn(i);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// Times async calls in bursts that fit in the ring, draining it between bursts
+// outside the timed region so no call degenerates into a cheap drop.
+template <typename F>
+double async_ns_per_call(Logger& logger, F&& fn, int iterations) {
+    constexpr int kBurst = static_cast<int>(Logger::kCapacity / 2);
+    std::chrono::steady_clock::duration elapsed{};
+    for (int done = 0; done < iterations; done += kBurst) {
+        logger.flush();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = done; i < done + kBurst; ++i) {
+            fn(i);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+}
+
+int main() {
+    std::FILE* null_file = std::fopen("/dev/null", "w");
+    if (!null_file) {
+        std::cerr << "cannot open /dev/null" << std::endl;
+        return 1;
+    }
+    std::ofstream null_stream("/dev/null");
+
+    double sync_ns = ns_per_call([&](int i) {
+        null_stream << "Successfully parsed " << i << " waypoints." << std::endl;
+    }, kIterations);
+
+    Logger async_logger(null_file, null_file);
+    double async_ns = async_ns_per_call(async_logger, [&](int i) {
+        LogLine(async_logger, LogLevel::Info, "start.parsed").field("waypoints", i);
+    }, kIterations);
+    async_logger.flush();
+
+    double filtered_ns = ns_per_call([&](int i) {
+        LogLine(async_logger, LogLevel::Debug, "start.parsed").field("waypoints", i);
+    }, kIterations);
+
+    const int threads = 4;
+    std::vector<double> thread_ns(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            thread_ns[t] = ns_per_call([&](int i) {
+                LogLine(async_logger, LogLevel::Info, "telemetry.served").field("route", "/battery").field("age_ms", i * 0.5);
+            }, static_cast<int>(Logger::kCapacity) / (2 * threads));
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double contended_ns = 0.0;
+    for (double ns : thread_ns) {
+        contended_ns += ns / threads;
+    }
+    async_logger.flush();
+
+    std::printf("std::endl (sync)        %8.1f ns/call\n", sync_ns);
+    std::printf("async logger            %8.1f ns/call\n", async_ns);
+    std::printf("async, level filtered   %8.1f ns/call\n", filtered_ns);
+    std::printf("async, %d threads        %8.1f ns/call per thread (%llu dropped)\n", threads, contended_ns,
+                static_cast<unsigned long long>(async_logger.dropped()));
+    std::fclose(null_file);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Route lookup cost as the number of literal endpoints grows: httplib's
+// ordered list of std::regex matchers against StaticRouter's perfect hash.
+// Each table holds the real telemetry routes plus synthetic /vehicles/N/...
+// paths; lookups hit /state (registered last, as the real server does) and
+// miss with an unknown path.
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "httplib.h"
+#include "static_router.h"
+
+namespace {
+
+constexpr int kIterations = 200000;
+
+template <typename F>
+double ns_per_call(F&& fn, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+std::vector<std::string> route_paths(size_t count) {
+    std::vector<std::string> paths = {"/hello", "/pause", "/abort", "/resume", "/telemetry", "/mission_progress",
+                                      "/battery", "/altitude", "/heading", "/telemetry/latency", "/metrics"};
+    for (size_t i = 0; paths.size() + 1 < count; ++i) {
+        paths.push_back("/vehicles/" + std::to_string(i / 4) + (i % 4 == 0 ? "/telemetry" : i % 4 == 1 ? "/battery"
+                                                                    : i % 4 == 2 ? "/state" : "/heading"));
+    }
+    paths.push_back("/state");
+    return paths;
+}
+
+}
+
+int main() {
+    size_t sink = 0;
+    std::printf("%6s %18s %18s %18s %18s\n", "routes", "regex hit (ns)", "regex miss (ns)", "static hit (ns)",
+                "static miss (ns)");
+    for (size_t count : {8, 16, 32, 64, 128}) {
+        auto paths = route_paths(count);
+        std::vector<std::unique_ptr<httplib::detail::MatcherBase>> regexes;
+        StaticRouter router;
+        for (const auto& path : paths) {
+            regexes.push_back(std::make_unique<httplib::detail::RegexMatcher>(path));
+            router.Get(path, [](const httplib::Request&, httplib::Response&) {});
+        }
+        router.build();
+
+        httplib::Request hit;
+        hit.path = "/state";
+        httplib::Request miss;
+        miss.path = "/does/not/exist";
+        auto regex_lookup = [&](httplib::Request& req) {
+            for (const auto& matcher : regexes) {
+                if (matcher->match(req)) {
+                    ++sink;
+                    return;
+                }
+            }
+        };
+        int iterations = static_cast<int>(kIterations * 8 / paths.size());
+        double regex_hit = ns_per_call([&] { regex_lookup(hit); }, iterations);
+        double regex_miss = ns_per_call([&] { regex_lookup(miss); }, iterations);
+        double static_hit = ns_per_call([&] { sink += router.find(hit.path) != nullptr; }, kIterations * 10);
+        double static_miss = ns_per_call([&] { sink += router.find(miss.path) != nullptr; }, kIterations * 10);
+        std::printf("%6zu %18.1f %18.1f %18.1f %18.1f\n", paths.size(), regex_hit, regex_miss, static_hit, static_miss);
+    }
+    return sink == 0;
+}
@@ -0,0 +1,109 @@
+// Speed profile planning time for dense print paths: a layered circular
+// bead at 2 cm spacing and a raster with 90 degree turns, 100k and 1M
+// points each. Every profile is checked against the speed, acceleration
+// and jerk limits.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "velocity_planner.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::vector<NedPoint> spiral(size_t points) {
+    // 5 m radius, 2 cm between points, climbing 2 cm per lap.
+    std::vector<NedPoint> path;
+    path.reserve(points);
+    double step = 0.02 / 5.0;
+    for (size_t i = 0; i < points; ++i) {
+        double angle = i * step;
+        path.push_back({5.0 * std::cos(angle), 5.0 * std::sin(angle), -10.0 - 0.02 * angle / (2.0 * kPi)});
+    }
+    return path;
+}
+
+std::vector<NedPoint> raster(size_t points) {
+    // 1 m lanes 5 cm apart, sampled every 5 cm: a 90 degree turn every 21 points.
+    std::vector<NedPoint> path;
+    path.reserve(points);
+    NedPoint at{0.0, 0.0, -10.0};
+    for (size_t i = 0; i < points; ++i) {
+        path.push_back(at);
+        size_t step = i % 21;
+        size_t lane = i / 21;
+        if (step == 20) {
+            at.east_m += 0.05;
+        } else {
+            at.north_m += (lane % 2) ? -0.05 : 0.05;
+        }
+    }
+    return path;
+}
+
+struct Check {
+    double max_speed = 0.0;
+    double max_accel = 0.0;
+    double p99_jerk = 0.0;
+    double max_jerk = 0.0;
+};
+
+Check check(const VelocityProfile& profile) {
+    Check result;
+    std::vector<double> jerks;
+    double last_accel = 0.0;
+    double last_dt = 0.0;
+    for (size_t i = 0; i + 1 < profile.speeds.size(); ++i) {
+        double v0 = profile.speeds[i];
+        double v1 = profile.speeds[i + 1];
+        double dt = profile.times[i + 1] - profile.times[i];
+        double accel = dt > 0.0 ? (v1 - v0) / dt : 0.0;
+        result.max_speed = std::max(result.max_speed, v1);
+        result.max_accel = std::max(result.max_accel, std::fabs(accel));
+        if (i > 0 && dt + last_dt > 0.0) {
+            jerks.push_back(std::fabs(accel - last_accel) / ((dt + last_dt) / 2.0));
+        }
+        last_accel = accel;
+        last_dt = dt;
+    }
+    if (!jerks.empty()) {
+        std::sort(jerks.begin(), jerks.end());
+        result.p99_jerk = jerks[jerks.size() * 99 / 100];
+        result.max_jerk = jerks.back();
+    }
+    return result;
+}
+
+bool run(const char* name, const std::vector<NedPoint>& path, const VelocityLimits& limits) {
+    auto start = std::chrono::steady_clock::now();
+    VelocityProfile profile = plan_velocity_profile(path, limits);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Check result = check(profile);
+    std::printf("%-7s %8zu points: %7.1f ms (%.0f ns/point), duration %.1f s, max %.2f m/s, max accel %.2f m/s^2, "
+                "jerk p99 %.2f max %.2f m/s^3\n",
+                name, profile.points.size(), ms, ms * 1e6 / profile.points.size(), profile.duration_s(),
+                result.max_speed, result.max_accel, result.p99_jerk, result.max_jerk);
+    // Finite differences of a sampled profile overshoot a little: allow 5%
+    // on acceleration and jerk.
+    bool ok = result.max_speed <= limits.max_speed_m_s + 1e-9 && result.max_accel <= limits.max_accel_m_s2 * 1.05 &&
+              result.max_jerk <= limits.max_jerk_m_s3 * 1.05;
+    if (!ok) {
+        std::printf("%s: profile exceeds the limits\n", name);
+    }
+    return ok;
+}
+
+}
+
+int main() {
+    VelocityLimits limits;
+    limits.max_speed_m_s = 2.0;
+    bool ok = true;
+    for (size_t points : {size_t{100000}, size_t{1000000}}) {
+        ok = run("spiral", spiral(points), limits) && ok;
+        ok = run("raster", raster(points), limits) && ok;
+    }
+    return ok ? 0 : 1;
+}
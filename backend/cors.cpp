@@ -0,0 +1,70 @@
+#include "cors.h"
+
+#include <algorithm>
+
+namespace {
+
+// Preflight answers are cached by the browser for this long, so most
+// cross-origin polls skip the OPTIONS round trip entirely.
+const char* const kAllowMethods = "GET, POST, PUT, DELETE, OPTIONS";
+const char* const kAllowHeaders = "Content-Type, If-None-Match";
+const char* const kMaxAge = "600";
+
+}
+
+CorsPolicy::CorsPolicy(const std::vector<std::string>& allowed_origins) {
+    for (const auto& origin : allowed_origins) {
+        if (origin == "*") {
+            allow_any_ = true;
+        } else if (!origin.empty()) {
+            origins_.push_back(origin);
+        }
+    }
+    if (origins_.empty()) {
+        allow_any_ = true;
+    }
+    // With an allowlist the Allow-Origin value depends on the request, so only
+    // Vary is static; caches must not hand one origin's answer to another.
+    static_headers_ = allow_any_ ? "Access-Control-Allow-Origin: *\r\n" : "Vary: Origin\r\n";
+    // Lets console scripts read the telemetry ETag for conditional polls.
+    static_headers_ += "Access-Control-Expose-Headers: ETag\r\n";
+}
+
+bool CorsPolicy::allows(const std::string& origin) const {
+    return allow_any_ || std::find(origins_.begin(), origins_.end(), origin) != origins_.end();
+}
+
+httplib::Server::HandlerResponse CorsPolicy::handle(const httplib::Request& req, httplib::Response& res) const {
+    if (!allow_any_) {
+        auto origin = req.get_header_value("Origin");
+        if (!origin.empty() && allows(origin)) {
+            res.set_header("Access-Control-Allow-Origin", origin);
+        }
+    }
+    if (req.method != "OPTIONS") {
+        return httplib::Server::HandlerResponse::Unhandled;
+    }
+    res.status = 204;
+    res.set_header("Access-Control-Allow-Methods", kAllowMethods);
+    res.set_header("Access-Control-Allow-Headers", kAllowHeaders);
+    res.set_header("Access-Control-Max-Age", kMaxAge);
+    return httplib::Server::HandlerResponse::Handled;
+}
+
+ssize_t CorsPolicy::write_headers(httplib::Stream& strm, const httplib::Headers& headers) const {
+    std::string block;
+    size_t size = static_headers_.size() + 2;
+    for (const auto& header : headers) {
+        size += header.first.size() + header.second.size() + 4;
+    }
+    block.reserve(size);
+    for (const auto& header : headers) {
+        block += header.first;
+        block += ": ";
+        block += header.second;
+        block += "\r\n";
+    }
+    block += static_headers_;
+    block += "\r\n";
+    return strm.write(block.data(), block.size());
+}
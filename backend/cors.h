@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "httplib.h"
+
+// Cross-origin policy shared by the HTTP servers. Header lines that are the
+// same on every response are rendered once at startup and spliced in by the
+// header writer, instead of being inserted into each Response's header map.
+// Preflights are answered from the pre-routing handler, before any routing.
+class CorsPolicy {
+public:
+    // An empty list or a "*" entry allows every origin.
+    explicit CorsPolicy(const std::vector<std::string>& allowed_origins);
+
+    // Pre-routing step. Answers OPTIONS preflights with 204 (Handled) and,
+    // with an allowlist, echoes back an allowed Origin; otherwise Unhandled.
+    httplib::Server::HandlerResponse handle(const httplib::Request& req, httplib::Response& res) const;
+
+    // CRLF-terminated header lines to append to every response.
+    const std::string& static_headers() const { return static_headers_; }
+
+    // Replacement for httplib's default header writer: writes `headers`,
+    // static_headers() and the blank line in a single write.
+    ssize_t write_headers(httplib::Stream& strm, const httplib::Headers& headers) const;
+
+    bool allows(const std::string& origin) const;
+
+private:
+    bool allow_any_ = false;
+    std::vector<std::string> origins_;
+    std::string static_headers_;
+};
@@ -0,0 +1,273 @@
+#include "deconfliction.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+
+Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 operator*(const Vec3& a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+double dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vec3 position_at(const PathSegment& segment, double t) {
+    double span = segment.t1 - segment.t0;
+    return segment.p0 + (segment.p1 - segment.p0) * (span > 0.0 ? (t - segment.t0) / span : 0.0);
+}
+
+// Closest approach of two legs over the time both are flown. Relative motion
+// is linear, so the minimum of |d0 + dv * u| has a closed form.
+bool closest_approach(const PathSegment& a, const PathSegment& b, double& time_s, double& distance_m) {
+    double start = std::max(a.t0, b.t0);
+    double end = std::min(a.t1, b.t1);
+    if (start > end) {
+        return false;
+    }
+    Vec3 d0 = position_at(a, start) - position_at(b, start);
+    Vec3 d1 = position_at(a, end) - position_at(b, end);
+    double span = end - start;
+    double u = 0.0;
+    if (span > 0.0) {
+        Vec3 dv = (d1 - d0) * (1.0 / span);
+        double speed2 = dot(dv, dv);
+        if (speed2 > 0.0) {
+            u = std::min(span, std::max(0.0, -dot(d0, dv) / speed2));
+        }
+        d0 = d0 + dv * u;
+    }
+    time_s = start + u;
+    distance_m = std::sqrt(dot(d0, d0));
+    return true;
+}
+
+// Grid cell of a piece's space-time bounding box corner, as signed indices.
+using Cell = std::array<int64_t, 4>;
+
+uint64_t cell_key(const Cell& cell) {
+    // 16 bits per axis; distant cells that alias only cost extra comparisons.
+    uint64_t key = 0;
+    for (int64_t index : cell) {
+        key = (key << 16) | (static_cast<uint64_t>(index) & 0xffff);
+    }
+    return key;
+}
+
+struct Piece {
+    PathSegment segment;
+    Cell lo;
+    Cell hi;
+};
+
+struct Entry {
+    uint64_t key;
+    uint32_t vehicle;
+    uint32_t piece;
+
+    bool operator<(const Entry& other) const {
+        return key != other.key ? key < other.key : vehicle != other.vehicle ? vehicle < other.vehicle : piece < other.piece;
+    }
+};
+
+}
+
+std::vector<PathSegment> mission_segments(uint32_t vehicle, const std::vector<mavsdk::Mission::MissionItem>& items,
+                                          const GeoOrigin& origin, double default_speed_m_s) {
+    std::vector<PathSegment> segments;
+    if (items.empty()) {
+        return segments;
+    }
+    if (items.size() == 1) {
+        Vec3 at = origin.to_local(items[0].latitude_deg, items[0].longitude_deg, items[0].relative_altitude_m);
+        segments.push_back({vehicle, 0, 0.0, 0.0, at, at});
+        return segments;
+    }
+    segments.reserve(items.size() - 1);
+    double t = 0.0;
+    Vec3 from = origin.to_local(items[0].latitude_deg, items[0].longitude_deg, items[0].relative_altitude_m);
+    for (size_t i = 0; i + 1 < items.size(); ++i) {
+        const auto& next = items[i + 1];
+        Vec3 to = origin.to_local(next.latitude_deg, next.longitude_deg, next.relative_altitude_m);
+        double speed = std::isfinite(items[i].speed_m_s) && items[i].speed_m_s > 0.0f ? items[i].speed_m_s
+                                                                                     : default_speed_m_s;
+        Vec3 delta = to - from;
+        double duration = std::sqrt(dot(delta, delta)) / speed;
+        segments.push_back({vehicle, static_cast<uint32_t>(i), t, t + duration, from, to});
+        t += duration;
+        from = to;
+    }
+    return segments;
+}
+
+void hold_at_mission_end(std::vector<PathSegment>& segments) {
+    std::unordered_map<uint32_t, size_t> last;  // vehicle -> its last segment
+    double end = 0.0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto it = last.emplace(segments[i].vehicle, i).first;
+        if (segments[i].t1 >= segments[it->second].t1) {
+            it->second = i;
+        }
+        end = std::max(end, segments[i].t1);
+    }
+    for (const auto& entry : last) {
+        PathSegment& final_leg = segments[entry.second];
+        if (final_leg.t1 >= end) {
+            continue;
+        }
+        if (final_leg.t0 == final_leg.t1) {
+            final_leg.t1 = end;  // single-item mission: stretch its hover
+            continue;
+        }
+        PathSegment hover{final_leg.vehicle, final_leg.leg + 1, final_leg.t1, end, final_leg.p1, final_leg.p1};
+        segments.push_back(hover);
+    }
+}
+
+std::vector<Conflict> find_conflicts(const std::vector<PathSegment>& segments, double separation_m,
+                                     size_t max_conflicts) {
+    std::vector<Conflict> conflicts;
+    if (segments.empty() || separation_m <= 0.0) {
+        return conflicts;
+    }
+    // Cut legs into pieces at most one separation long, so a piece's box
+    // (grown by half the separation) spans at most two cells per axis.
+    std::vector<PathSegment> pieces;
+    std::vector<double> durations;
+    for (const auto& segment : segments) {
+        Vec3 delta = segment.p1 - segment.p0;
+        size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(dot(delta, delta)) / separation_m)));
+        for (size_t i = 0; i < count; ++i) {
+            double t0 = segment.t0 + (segment.t1 - segment.t0) * i / count;
+            double t1 = segment.t0 + (segment.t1 - segment.t0) * (i + 1) / count;
+            pieces.push_back({segment.vehicle, segment.leg, t0, t1, position_at(segment, t0), position_at(segment, t1)});
+            durations.push_back(t1 - t0);
+        }
+    }
+    // Time buckets a few typical pieces long; slower (longer) pieces are cut
+    // again so none spans more than two buckets.
+    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+    double bucket_s = std::max(4.0 * durations[durations.size() / 2], 1e-3);
+    double cell_m = 2.0 * separation_m;
+    double margin = separation_m / 2.0;
+
+    std::vector<Piece> grid_pieces;
+    grid_pieces.reserve(pieces.size());
+    std::vector<Entry> entries;
+    entries.reserve(pieces.size() * 4);
+    for (const auto& piece : pieces) {
+        size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil((piece.t1 - piece.t0) / bucket_s)));
+        for (size_t i = 0; i < count; ++i) {
+            PathSegment part = piece;
+            part.t0 = piece.t0 + (piece.t1 - piece.t0) * i / count;
+            part.t1 = piece.t0 + (piece.t1 - piece.t0) * (i + 1) / count;
+            part.p0 = position_at(piece, part.t0);
+            part.p1 = position_at(piece, part.t1);
+            Piece grid_piece{part, {}, {}};
+            const double lo[3] = {std::min(part.p0.x, part.p1.x), std::min(part.p0.y, part.p1.y),
+                                  std::min(part.p0.z, part.p1.z)};
+            const double hi[3] = {std::max(part.p0.x, part.p1.x), std::max(part.p0.y, part.p1.y),
+                                  std::max(part.p0.z, part.p1.z)};
+            for (int axis = 0; axis < 3; ++axis) {
+                grid_piece.lo[axis] = static_cast<int64_t>(std::floor((lo[axis] - margin) / cell_m));
+                grid_piece.hi[axis] = static_cast<int64_t>(std::floor((hi[axis] + margin) / cell_m));
+            }
+            grid_piece.lo[3] = static_cast<int64_t>(std::floor(part.t0 / bucket_s));
+            grid_piece.hi[3] = static_cast<int64_t>(std::floor(part.t1 / bucket_s));
+            uint32_t index = static_cast<uint32_t>(grid_pieces.size());
+            Cell cell;
+            for (cell[0] = grid_piece.lo[0]; cell[0] <= grid_piece.hi[0]; ++cell[0]) {
+                for (cell[1] = grid_piece.lo[1]; cell[1] <= grid_piece.hi[1]; ++cell[1]) {
+                    for (cell[2] = grid_piece.lo[2]; cell[2] <= grid_piece.hi[2]; ++cell[2]) {
+                        for (cell[3] = grid_piece.lo[3]; cell[3] <= grid_piece.hi[3]; ++cell[3]) {
+                            entries.push_back({cell_key(cell), part.vehicle, index});
+                        }
+                    }
+                }
+            }
+            grid_pieces.push_back(grid_piece);
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    // One result per pair of legs, keyed by (vehicle, leg) of both sides.
+    struct PairKey {
+        uint32_t vehicle_a, leg_a, vehicle_b, leg_b;
+        bool operator==(const PairKey& o) const {
+            return vehicle_a == o.vehicle_a && leg_a == o.leg_a && vehicle_b == o.vehicle_b && leg_b == o.leg_b;
+        }
+    };
+    struct PairHash {
+        size_t operator()(const PairKey& k) const {
+            uint64_t h = (static_cast<uint64_t>(k.vehicle_a) << 32 | k.leg_a) * 0x9e3779b97f4a7c15ULL;
+            return static_cast<size_t>(h ^ ((static_cast<uint64_t>(k.vehicle_b) << 32 | k.leg_b) + (h >> 29)));
+        }
+    };
+    std::unordered_map<PairKey, size_t, PairHash> found;
+
+    for (size_t run = 0; run < entries.size();) {
+        size_t run_end = run;
+        while (run_end < entries.size() && entries[run_end].key == entries[run].key) {
+            ++run_end;
+        }
+        for (size_t i = run; i < run_end; ++i) {
+            // Entries are sorted by vehicle within a cell; start past our own.
+            size_t j = i + 1;
+            while (j < run_end && entries[j].vehicle == entries[i].vehicle) {
+                ++j;
+            }
+            for (; j < run_end; ++j) {
+                const Piece& a = grid_pieces[entries[i].piece];
+                const Piece& b = grid_pieces[entries[j].piece];
+                // Compare each pair once: in the lowest cell both boxes share.
+                Cell shared;
+                for (int axis = 0; axis < 4; ++axis) {
+                    shared[axis] = std::max(a.lo[axis], b.lo[axis]);
+                }
+                if (cell_key(shared) != entries[i].key) {
+                    continue;
+                }
+                double time_s = 0.0;
+                double distance_m = 0.0;
+                if (!closest_approach(a.segment, b.segment, time_s, distance_m) || distance_m >= separation_m) {
+                    continue;
+                }
+                const PathSegment& first = a.segment.vehicle < b.segment.vehicle ? a.segment : b.segment;
+                const PathSegment& second = a.segment.vehicle < b.segment.vehicle ? b.segment : a.segment;
+                PairKey key{first.vehicle, first.leg, second.vehicle, second.leg};
+                auto it = found.find(key);
+                if (it != found.end()) {
+                    Conflict& conflict = conflicts[it->second];
+                    if (distance_m < conflict.distance_m) {
+                        conflict.time_s = time_s;
+                        conflict.distance_m = distance_m;
+                    }
+                    continue;
+                }
+                if (conflicts.size() >= max_conflicts) {
+                    continue;
+                }
+                found.emplace(key, conflicts.size());
+                conflicts.push_back({first.vehicle, first.leg, second.vehicle, second.leg, time_s, distance_m});
+            }
+        }
+        run = run_end;
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [](const Conflict& a, const Conflict& b) { return a.time_s < b.time_s; });
+    return conflicts;
+}
+
+std::string conflicts_json(const std::vector<Conflict>& conflicts) {
+    std::string json = "[";
+    for (size_t i = 0; i < conflicts.size(); ++i) {
+        const Conflict& c = conflicts[i];
+        json += i ? ", " : " ";
+        json += "{ \"vehicle_a\": " + std::to_string(c.vehicle_a) + ", \"item_a\": " + std::to_string(c.leg_a) +
+                ", \"vehicle_b\": " + std::to_string(c.vehicle_b) + ", \"item_b\": " + std::to_string(c.leg_b) +
+                ", \"time_s\": " + std::to_string(c.time_s) + ", \"distance_m\": " + std::to_string(c.distance_m) +
+                " }";
+    }
+    json += conflicts.empty() ? "]" : " ]";
+    return json;
+}
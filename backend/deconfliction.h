@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mavsdk/plugins/mission/mission.h>
+#include "geo.h"
+
+// 4D deconfliction of fleet missions. Each mission is flattened into legs
+// flown at constant speed from a shared start time, in a local metric frame,
+// and legs of different vehicles that come within the separation distance
+// at the same time are reported.
+//
+// Assumptions, which /fleet/start only approximates:
+// - t = 0 is the go signal, and every vehicle is then at its first waypoint.
+//   The takeoff and transit from where each vehicle stands to its first
+//   waypoint are not checked.
+// - Legs are straight and flown at constant speed. Acceleration and hold
+//   times are ignored.
+// - A vehicle that finishes early hovers at its last waypoint until the last
+//   mission ends (see hold_at_mission_end). Landing or returning to launch
+//   afterwards is not checked.
+
+// One straight leg of one vehicle, between two waypoints, or a hover at one
+// waypoint (p0 == p1).
+struct PathSegment {
+    uint32_t vehicle = 0;
+    uint32_t leg = 0;  // index of the leg's first mission item, or of the hovered item
+    double t0 = 0.0;
+    double t1 = 0.0;
+    Vec3 p0;
+    Vec3 p1;
+};
+
+struct Conflict {
+    uint32_t vehicle_a = 0;
+    uint32_t leg_a = 0;
+    uint32_t vehicle_b = 0;
+    uint32_t leg_b = 0;
+    double time_s = 0.0;      // closest approach
+    double distance_m = 0.0;  // separation at closest approach
+};
+
+// Legs of one mission. Leg i flies items[i] -> items[i + 1] at items[i]'s
+// speed_m_s, or `default_speed_m_s` if that is not set. A single-item
+// mission is a zero-length hover at that item.
+std::vector<PathSegment> mission_segments(uint32_t vehicle, const std::vector<mavsdk::Mission::MissionItem>& items,
+                                          const GeoOrigin& origin, double default_speed_m_s);
+
+// Keeps every vehicle in the airspace until the last mission ends: a vehicle
+// whose mission ends earlier gets a hover segment at its last waypoint, since
+// PX4 loiters there rather than leaving.
+void hold_at_mission_end(std::vector<PathSegment>& segments);
+
+// Pairs of legs of different vehicles that come closer than `separation_m`
+// while both are flown, one entry (the closest approach) per pair of legs,
+// ordered by time. Legs are cut into pieces no longer than the separation
+// and bucketed in a hashed space-time grid, so only pieces that share a
+// cell are compared. Stops after `max_conflicts`.
+std::vector<Conflict> find_conflicts(const std::vector<PathSegment>& segments, double separation_m,
+                                     size_t max_conflicts = 1000);
+
+// JSON array of `conflicts`, legs named by mission item index.
+std::string conflicts_json(const std::vector<Conflict>& conflicts);
@@ -0,0 +1,173 @@
+#include "delta_stream.h"
+#include "telemetry_frame.h"
+
+namespace {
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Heading differences take the short way round: 359.9 -> 0.1 is +0.2 degrees.
+int64_t wrap_cdeg(int64_t cdeg) {
+    return ((cdeg + 18000) % 36000 + 36000) % 36000 - 18000;
+}
+
+bool read_varint(const uint8_t** data, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*data == end) {
+            return false;
+        }
+        uint8_t byte = *(*data)++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+void append_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::string DeltaEncoder::next(TelemetryStore& store) {
+    uint64_t version = store.version();
+    if (started_ && version == sent_version_) {
+        return std::string();
+    }
+
+    if (store.position.seq() != channel_seq_[kPosition]) {
+        auto sample = store.position.read();
+        channel_seq_[kPosition] = sample.seq;
+        if (sample.valid()) {
+            current_.values[kDeltaLatitude] = scale_degrees_e7(sample.value.latitude);
+            current_.values[kDeltaLongitude] = scale_degrees_e7(sample.value.longitude);
+            current_.known |= 1 << kDeltaLatitude | 1 << kDeltaLongitude;
+        }
+    }
+    if (store.altitude.seq() != channel_seq_[kAltitude]) {
+        auto sample = store.altitude.read();
+        channel_seq_[kAltitude] = sample.seq;
+        if (sample.valid()) {
+            current_.values[kDeltaAltitude] = scale_altitude_dm(sample.value.relative_altitude_m);
+            current_.known |= 1 << kDeltaAltitude;
+        }
+    }
+    if (store.heading.seq() != channel_seq_[kHeading]) {
+        auto sample = store.heading.read();
+        channel_seq_[kHeading] = sample.seq;
+        if (sample.valid()) {
+            current_.values[kDeltaHeading] = scale_heading_cdeg(sample.value.heading_deg);
+            current_.known |= 1 << kDeltaHeading;
+        }
+    }
+    if (store.battery.seq() != channel_seq_[kBattery]) {
+        auto sample = store.battery.read();
+        channel_seq_[kBattery] = sample.seq;
+        if (sample.valid()) {
+            current_.values[kDeltaBattery] = scale_battery_percent(sample.value.remaining_percent);
+            current_.known |= 1 << kDeltaBattery;
+        }
+    }
+    if (store.mission_progress.seq() != channel_seq_[kMission]) {
+        auto sample = store.mission_progress.read();
+        channel_seq_[kMission] = sample.seq;
+        if (sample.valid()) {
+            current_.values[kDeltaMissionCurrent] = sample.value.current;
+            current_.values[kDeltaMissionTotal] = sample.value.total;
+            current_.known |= 1 << kDeltaMissionCurrent | 1 << kDeltaMissionTotal;
+        }
+    }
+
+    bool keyframe = !started_ || since_keyframe_ >= keyframe_interval_;
+    uint8_t mask = 0;
+    for (int field = 0; field < kDeltaFieldCount; ++field) {
+        uint8_t bit = static_cast<uint8_t>(1 << field);
+        if ((current_.known & bit) &&
+            (keyframe || !(sent_.known & bit) || current_.values[field] != sent_.values[field])) {
+            mask |= bit;
+        }
+    }
+    // Changes below the encoding's resolution are not worth a message; the
+    // version is not advanced, so the next delta's seq step still adds up.
+    if (!keyframe && mask == 0) {
+        return std::string();
+    }
+
+    std::string out;
+    out.push_back(static_cast<char>(mask | (keyframe ? kDeltaKeyframeBit : 0)));
+    append_varint(out, keyframe ? version : version - sent_version_);
+    for (int field = 0; field < kDeltaFieldCount; ++field) {
+        if (!(mask & (1 << field))) {
+            continue;
+        }
+        int64_t value = current_.values[field];
+        if (!keyframe) {
+            value -= sent_.values[field];
+            if (field == kDeltaHeading) {
+                value = wrap_cdeg(value);
+            }
+        }
+        append_varint(out, zigzag(value));
+    }
+    since_keyframe_ = keyframe ? 0 : since_keyframe_ + 1;
+    started_ = true;
+    sent_version_ = version;
+    sent_ = current_;
+    return out;
+}
+
+bool apply_delta(const uint8_t** data, const uint8_t* end, DeltaSnapshot& snapshot) {
+    if (*data == end) {
+        return false;
+    }
+    uint8_t header = *(*data)++;
+    bool keyframe = header & kDeltaKeyframeBit;
+    uint8_t mask = header & ~kDeltaKeyframeBit;
+    if (!keyframe && !snapshot.synced) {
+        return false;
+    }
+    uint64_t seq = 0;
+    if (!read_varint(data, end, seq)) {
+        return false;
+    }
+    DeltaSnapshot next = snapshot;
+    if (keyframe) {
+        next = DeltaSnapshot{};
+        next.synced = true;
+        next.seq = seq;
+    } else {
+        next.seq += seq;
+    }
+    for (int field = 0; field < kDeltaFieldCount; ++field) {
+        if (!(mask & (1 << field))) {
+            continue;
+        }
+        uint64_t raw = 0;
+        if (!read_varint(data, end, raw)) {
+            return false;
+        }
+        int64_t value = unzigzag(raw);
+        if (!keyframe) {
+            value += next.values[field];
+            if (field == kDeltaHeading) {
+                value = wrap_cdeg(value);
+            }
+        }
+        next.values[field] = value;
+        next.known |= static_cast<uint8_t>(1 << field);
+    }
+    snapshot = next;
+    return true;
+}
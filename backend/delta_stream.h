@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "telemetry_store.h"
+
+// Delta-encoded telemetry for /stream?encoding=delta. Consecutive snapshots
+// differ in a few fields by small amounts, so after a periodic keyframe
+// each message carries only the fields that changed, as zigzag varints of
+// the difference. Fields use the fixed-point scales of telemetry_frame.h.
+//
+// Message layout (messages are self-delimiting and sent back to back):
+//   u8      header: bit 7 set for a keyframe, bits 0-6 the field-presence mask
+//   varint  keyframe: store version; delta: version minus the previous message's
+//   varint  per present field, in DeltaField order: zigzag(value) in a
+//           keyframe, zigzag(value - previous value) in a delta
+// A keyframe lists every field that has a sample; absent fields are unknown.
+enum DeltaField {
+    kDeltaLatitude,        // degrees * 1e7
+    kDeltaLongitude,       // degrees * 1e7
+    kDeltaAltitude,        // relative, decimetres
+    kDeltaHeading,         // centidegrees in [-18000, 18000); deltas wrap
+    kDeltaBattery,         // percent
+    kDeltaMissionCurrent,
+    kDeltaMissionTotal,
+    kDeltaFieldCount
+};
+
+constexpr uint8_t kDeltaKeyframeBit = 0x80;
+
+struct DeltaSnapshot {
+    bool synced = false;  // a keyframe has been applied
+    uint64_t seq = 0;
+    uint8_t known = 0;  // bit per DeltaField
+    int64_t values[kDeltaFieldCount] = {};
+};
+
+// Per-connection encoder. Channels whose sequence number has not moved since
+// the last call are not read at all.
+class DeltaEncoder {
+public:
+    // A keyframe is sent first and then after every `keyframe_interval`
+    // deltas, so a client that misses the start resynchronizes quickly.
+    explicit DeltaEncoder(uint32_t keyframe_interval) : keyframe_interval_(keyframe_interval) {}
+
+    // Next message, or an empty string if no field changed at this resolution.
+    std::string next(TelemetryStore& store);
+
+private:
+    enum Channel { kPosition, kAltitude, kHeading, kBattery, kMission, kChannelCount };
+
+    uint32_t keyframe_interval_;
+    uint32_t since_keyframe_ = 0;
+    bool started_ = false;
+    uint64_t sent_version_ = 0;
+    uint64_t channel_seq_[kChannelCount] = {};
+    DeltaSnapshot current_;
+    DeltaSnapshot sent_;
+};
+
+// Applies one message from [*data, end) to `snapshot` and advances *data.
+// Returns false on a truncated message or a delta before the first keyframe.
+bool apply_delta(const uint8_t** data, const uint8_t* end, DeltaSnapshot& snapshot);
+
+void append_varint(std::string& out, uint64_t value);
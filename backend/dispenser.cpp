@@ -0,0 +1,148 @@
+#include "dispenser.h"
+
+#include <cmath>
+#include "logger.h"
+#include "realtime.h"
+
+namespace {
+
+// Commands closer than this to the last one sent are not re-sent.
+constexpr float kCommandDeadband = 0.002f;
+constexpr auto kRefreshInterval = std::chrono::seconds(1);
+// Velocity older than this turns the pump off.
+constexpr auto kStaleAfter = std::chrono::milliseconds(500);
+
+int64_t steady_ns(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+}
+
+DispenserController::DispenserController(mavsdk::Action& action, const DispenserConfig& config)
+    : action_(action), actuator_(config.actuator), table_(config),
+      period_(static_cast<int64_t>(1e9 / config.rate_hz)) {
+    thread_ = std::thread(&DispenserController::run, this);
+}
+
+DispenserController::~DispenserController() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_requested_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    send(0.0f);
+}
+
+void DispenserController::on_velocity(const mavsdk::Telemetry::VelocityNed& velocity) {
+    ground_speed_m_s_.store(std::hypot(velocity.north_m_s, velocity.east_m_s), std::memory_order_relaxed);
+    sample_ns_.store(steady_ns(std::chrono::steady_clock::now()), std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        sample_pending_ = true;
+    }
+    wake_.notify_one();
+}
+
+void DispenserController::send(float command) {
+    auto failures = send_failures_;
+    action_.set_actuator_async(actuator_, command, [failures](mavsdk::Action::Result result) {
+        if (result != mavsdk::Action::Result::Success) {
+            failures->fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    command_.store(command, std::memory_order_relaxed);
+    commands_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DispenserController::run() {
+    if (!raise_thread_priority()) {
+        log_warn("dispenser.realtime_unavailable");
+    }
+    auto deadline = std::chrono::steady_clock::now() + period_;
+    auto last_sent = std::chrono::steady_clock::time_point{};
+    bool sent_once = false;
+    float last_command = 0.0f;
+    while (true) {
+        bool new_sample = false;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait_until(lock, deadline, [this] { return stop_requested_ || sample_pending_; });
+            if (stop_requested_) {
+                break;
+            }
+            new_sample = sample_pending_;
+            sample_pending_ = false;
+        }
+        // A new sample is acted on at once; the deadline tick still runs
+        // when samples stop, to notice they are stale and to refresh.
+        auto now = std::chrono::steady_clock::now();
+        bool on_deadline = now >= deadline;
+        if (on_deadline) {
+            lateness_.record(now - deadline);
+        }
+
+        int64_t sample_ns = sample_ns_.load(std::memory_order_acquire);
+        double speed = ground_speed_m_s_.load(std::memory_order_relaxed);
+        double scale = flow_scale_.load(std::memory_order_relaxed);
+        auto age = std::chrono::nanoseconds(steady_ns(now) - sample_ns);
+        float command = 0.0f;
+        bool from_sample = false;
+        if (scale > 0.0) {
+            if (sample_ns == 0 || age > kStaleAfter) {
+                stale_ticks_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                command = table_.command(speed, scale);
+                from_sample = true;
+                if (table_.saturated(speed, scale)) {
+                    saturated_ticks_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+        if (!sent_once || std::fabs(command - last_command) > kCommandDeadband || now - last_sent >= kRefreshInterval) {
+            send(command);
+            // Only a tick woken by a new sample measures the controller;
+            // deadline ticks act on a sample that may be long settled.
+            if (from_sample && new_sample) {
+                latency_.record(std::chrono::steady_clock::now() - std::chrono::steady_clock::time_point(
+                                                                       std::chrono::nanoseconds(sample_ns)));
+            }
+            last_command = command;
+            last_sent = now;
+            sent_once = true;
+        }
+
+        if (!on_deadline) {
+            continue;
+        }
+        deadline += period_;
+        while (deadline <= now) {
+            deadline += period_;
+            missed_deadlines_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string DispenserController::status_json() const {
+    int64_t sample_ns = sample_ns_.load();
+    double age_s = sample_ns ? (steady_ns(std::chrono::steady_clock::now()) - sample_ns) / 1e9 : -1.0;
+    return "{ \"flow\": " + std::to_string(flow()) + ", \"command\": " + std::to_string(command_.load()) +
+           ", \"ground_speed_m_s\": " + std::to_string(ground_speed_m_s_.load()) +
+           ", \"velocity_age_s\": " + std::to_string(age_s) + ", \"commands\": " + std::to_string(commands_.load()) +
+           ", \"stale_ticks\": " + std::to_string(stale_ticks_.load()) +
+           ", \"saturated_ticks\": " + std::to_string(saturated_ticks_.load()) +
+           ", \"missed_deadlines\": " + std::to_string(missed_deadlines_.load()) +
+           ", \"send_failures\": " + std::to_string(send_failures_->load()) +
+           ", \"latency\": " + latency_.snapshot().to_json() + ", \"lateness\": " + lateness_.snapshot().to_json() +
+           " }";
+}
+
+DispenserController::Stats DispenserController::stats() const {
+    Stats stats;
+    stats.commands = commands_.load();
+    stats.stale_ticks = stale_ticks_.load();
+    stats.saturated_ticks = saturated_ticks_.load();
+    stats.latency = latency_.snapshot();
+    stats.lateness = lateness_.snapshot();
+    return stats;
+}
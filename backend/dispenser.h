@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+#include "flow_table.h"
+#include "latency_histogram.h"
+
+// Keeps the foam bead the same width whatever the vehicle's speed: a
+// dedicated thread turns each horizontal ground speed sample into a pump
+// command from a FlowTable and drives the pump actuator with it.
+//
+// The thread wakes as soon as a sample arrives, and otherwise at absolute
+// deadlines like the offboard stream. It asks for SCHED_FIFO where allowed.
+// Commands are sent without waiting for the acknowledgement. They go out
+// only when the command moves by more than a dead band, or once a second as
+// a refresh. If velocity telemetry goes stale the pump is turned off.
+class DispenserController {
+public:
+    DispenserController(mavsdk::Action& action, const DispenserConfig& config);
+    ~DispenserController();
+
+    DispenserController(const DispenserController&) = delete;
+    DispenserController& operator=(const DispenserController&) = delete;
+
+    // Velocity telemetry callback; stores the sample for the next tick.
+    void on_velocity(const mavsdk::Telemetry::VelocityNed& velocity);
+    // Flow relative to the configured bead: 0 stops dispensing (the start
+    // state), 1 is the nominal bead.
+    void set_flow(double scale) { flow_scale_.store(scale, std::memory_order_relaxed); }
+    double flow() const { return flow_scale_.load(std::memory_order_relaxed); }
+
+    std::string status_json() const;
+    // Command counters and latency histograms for /metrics.
+    struct Stats {
+        uint64_t commands = 0;
+        uint64_t stale_ticks = 0;
+        uint64_t saturated_ticks = 0;
+        LatencyHistogram::Snapshot latency;
+        LatencyHistogram::Snapshot lateness;
+    };
+    Stats stats() const;
+
+private:
+    void run();
+    void send(float command);
+
+    mavsdk::Action& action_;
+    int actuator_;
+    FlowTable table_;
+    std::chrono::nanoseconds period_;
+
+    std::atomic<double> flow_scale_{0.0};
+    // Latest sample: ground speed and steady_clock arrival time.
+    std::atomic<double> ground_speed_m_s_{0.0};
+    std::atomic<int64_t> sample_ns_{0};
+
+    std::thread thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_requested_ = false;
+    bool sample_pending_ = false;
+
+    std::atomic<float> command_{0.0f};
+    std::atomic<uint64_t> commands_{0};
+    std::atomic<uint64_t> stale_ticks_{0};
+    std::atomic<uint64_t> saturated_ticks_{0};
+    std::atomic<uint64_t> missed_deadlines_{0};
+    // Shared with acknowledgement callbacks, which may outlive the controller.
+    std::shared_ptr<std::atomic<uint64_t>> send_failures_ = std::make_shared<std::atomic<uint64_t>>(0);
+    // Velocity sample arrival to its command being queued with
+    // set_actuator_async (not acknowledged), on ticks woken by that sample.
+    LatencyHistogram latency_;
+    LatencyHistogram lateness_;  // deadline tick wake-up past its deadline
+};
@@ -0,0 +1,467 @@
+#include "event_server.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+constexpr size_t kMaxRequestHead = 8192;
+// Bytes read from one connection per wake-up, so a fast sender cannot starve
+// the rest of its loop; level-triggered epoll reports the remainder.
+constexpr size_t kMaxReadPerWake = 16 * 1024;
+// Stream connections whose unsent backlog exceeds this skip ticks instead of
+// buffering without bound behind a slow client.
+constexpr size_t kMaxStreamBacklog = 256 * 1024;
+constexpr auto kStreamTick = std::chrono::milliseconds(10);
+constexpr auto kIdleTimeout = std::chrono::seconds(60);
+constexpr auto kMinStreamPeriod = std::chrono::milliseconds(10);
+constexpr auto kMaxStreamPeriod = std::chrono::milliseconds(10000);
+
+}
+
+struct EventLoopServer::Route {
+    httplib::Server::Handler handler;
+    StreamHandler stream_handler;
+    std::chrono::milliseconds period{0};
+};
+
+struct EventLoopServer::Connection {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    size_t out_offset = 0;
+    bool writing = false;
+    bool close_after_write = false;
+    // The client shut down its side: answer what it sent, then close.
+    bool peer_closed = false;
+    StreamProducer producer;
+    std::chrono::milliseconds period{0};
+    std::chrono::steady_clock::time_point next_push;
+    std::chrono::steady_clock::time_point last_activity;
+};
+
+struct EventLoopServer::Loop {
+    int epoll_fd = -1;
+    int listen_fd = -1;
+    int timer_fd = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::chrono::steady_clock::time_point last_sweep;
+};
+
+EventLoopServer::EventLoopServer(size_t loop_threads) : loop_threads_(loop_threads ? loop_threads : 1) {}
+
+EventLoopServer::~EventLoopServer() { stop(); }
+
+void EventLoopServer::set_pre_routing_handler(httplib::Server::HandlerWithResponse handler) {
+    pre_routing_handler_ = std::move(handler);
+}
+
+void EventLoopServer::Get(const std::string& path, httplib::Server::Handler handler) {
+    auto route = std::make_unique<Route>();
+    route->handler = std::move(handler);
+    routes_[path] = std::move(route);
+}
+
+void EventLoopServer::Stream(const std::string& path, StreamHandler handler, std::chrono::milliseconds period) {
+    auto route = std::make_unique<Route>();
+    route->stream_handler = std::move(handler);
+    route->period = period;
+    routes_[path] = std::move(route);
+}
+
+#if defined(__linux__)
+
+namespace {
+
+int open_listener(const std::string& host, int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool epoll_set(int epoll_fd, int op, int fd, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return ::epoll_ctl(epoll_fd, op, fd, &event) == 0;
+}
+
+bool wants_close(const httplib::Request& req) {
+    auto connection = req.get_header_value("Connection");
+    if (req.version == "HTTP/1.0") {
+        return !httplib::detail::case_ignore::equal(connection, "keep-alive");
+    }
+    return httplib::detail::case_ignore::equal(connection, "close");
+}
+
+void append_headers(std::string& out, const httplib::Response& res) {
+    for (const auto& header : res.headers) {
+        out += header.first;
+        out += ": ";
+        out += header.second;
+        out += "\r\n";
+    }
+}
+
+}
+
+bool EventLoopServer::listen(const std::string& host, int port) {
+    for (size_t i = 0; i < loop_threads_; ++i) {
+        auto loop = std::make_unique<Loop>();
+        loop->listen_fd = open_listener(host, port);
+        loop->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        loop->timer_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (loop->listen_fd < 0 || loop->epoll_fd < 0 || loop->timer_fd < 0) {
+            log_error("event_server.listen_failed").field("host", host).field("port", port).field("errno", errno);
+            loops_.push_back(std::move(loop));
+            stop();
+            return false;
+        }
+        itimerspec tick{};
+        tick.it_interval.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(kStreamTick).count();
+        tick.it_value = tick.it_interval;
+        ::timerfd_settime(loop->timer_fd, 0, &tick, nullptr);
+        epoll_set(loop->epoll_fd, EPOLL_CTL_ADD, loop->listen_fd, EPOLLIN);
+        epoll_set(loop->epoll_fd, EPOLL_CTL_ADD, loop->timer_fd, EPOLLIN);
+        loops_.push_back(std::move(loop));
+    }
+    running_ = true;
+    for (auto& loop : loops_) {
+        Loop* raw = loop.get();
+        threads_.emplace_back([this, raw] { run(*raw); });
+    }
+    return true;
+}
+
+void EventLoopServer::stop() {
+    running_ = false;
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+    for (auto& loop : loops_) {
+        for (auto& entry : loop->connections) {
+            ::close(entry.first);
+        }
+        loop->connections.clear();
+        for (int fd : {loop->listen_fd, loop->timer_fd, loop->epoll_fd}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+    loops_.clear();
+    connections_ = 0;
+}
+
+void EventLoopServer::run(Loop& loop) {
+    epoll_event events[256];
+    while (running_) {
+        int ready = ::epoll_wait(loop.epoll_fd, events, 256, 100);
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == loop.listen_fd) {
+                for (;;) {
+                    int client = ::accept4(loop.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (client < 0) {
+                        break;
+                    }
+                    int on = 1;
+                    ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    auto conn = std::make_unique<Connection>();
+                    conn->fd = client;
+                    conn->last_activity = std::chrono::steady_clock::now();
+                    epoll_set(loop.epoll_fd, EPOLL_CTL_ADD, client, EPOLLIN | EPOLLRDHUP);
+                    loop.connections[client] = std::move(conn);
+                    connections_.fetch_add(1, std::memory_order_relaxed);
+                }
+            } else if (fd == loop.timer_fd) {
+                uint64_t expirations;
+                while (::read(loop.timer_fd, &expirations, sizeof(expirations)) > 0) {
+                }
+                push_streams(loop);
+            } else {
+                auto it = loop.connections.find(fd);
+                if (it == loop.connections.end()) {
+                    continue;
+                }
+                Connection& conn = *it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    close_connection(loop, fd);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !flush(loop, conn)) {
+                    continue;
+                }
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP)) {
+                    on_readable(loop, conn);
+                }
+            }
+        }
+    }
+}
+
+void EventLoopServer::on_readable(Loop& loop, Connection& conn) {
+    if (conn.peer_closed) {
+        return;
+    }
+    char buffer[4096];
+    size_t read_now = 0;
+    while (read_now < kMaxReadPerWake && conn.in.size() <= kMaxRequestHead) {
+        ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            read_now += static_cast<size_t>(n);
+            // Stream clients have nothing more to say; discard anything they send.
+            if (!conn.producer) {
+                conn.in.append(buffer, static_cast<size_t>(n));
+            }
+            continue;
+        }
+        if (n == 0) {
+            if (conn.producer) {
+                close_connection(loop, conn.fd);
+                return;
+            }
+            // Half-close: stop reading, but still answer buffered requests.
+            conn.peer_closed = true;
+            epoll_set(loop.epoll_fd, EPOLL_CTL_MOD, conn.fd, conn.writing ? EPOLLOUT : 0);
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close_connection(loop, conn.fd);
+            return;
+        }
+        break;
+    }
+    conn.last_activity = std::chrono::steady_clock::now();
+    size_t end;
+    while (!conn.producer && !conn.close_after_write && (end = conn.in.find("\r\n\r\n")) != std::string::npos) {
+        std::string head = conn.in.substr(0, end);
+        conn.in.erase(0, end + 4);
+        on_request(conn, head);
+    }
+    if (conn.in.size() > kMaxRequestHead) {
+        conn.out += "HTTP/1.1 431 Request Header Fields Too Large\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        conn.close_after_write = true;
+        conn.in.clear();
+    }
+    if (conn.peer_closed) {
+        conn.close_after_write = true;
+    }
+    flush(loop, conn);
+}
+
+void EventLoopServer::on_request(Connection& conn, const std::string& head) {
+    httplib::Request req;
+    httplib::Response res;
+    size_t line_end = head.find("\r\n");
+    std::string request_line = head.substr(0, line_end);
+    size_t first = request_line.find(' ');
+    size_t second = request_line.find(' ', first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+        conn.out += "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        conn.close_after_write = true;
+        return;
+    }
+    req.method = request_line.substr(0, first);
+    req.target = request_line.substr(first + 1, second - first - 1);
+    req.version = request_line.substr(second + 1);
+    size_t query = req.target.find('?');
+    req.path = httplib::detail::decode_url(req.target.substr(0, query), false);
+    if (query != std::string::npos) {
+        httplib::detail::parse_query_text(req.target.substr(query + 1), req.params);
+    }
+    size_t pos = line_end == std::string::npos ? head.size() : line_end + 2;
+    while (pos < head.size()) {
+        size_t next = head.find("\r\n", pos);
+        if (next == std::string::npos) {
+            next = head.size();
+        }
+        httplib::detail::parse_header(head.data() + pos, head.data() + next,
+                                      [&](const std::string& key, const std::string& value) {
+                                          req.headers.emplace(key, value);
+                                      });
+        pos = next + 2;
+    }
+
+    bool close = wants_close(req);
+    const Route* route = nullptr;
+    auto it = routes_.find(req.path);
+    if (it != routes_.end()) {
+        route = it->second.get();
+    }
+    StreamProducer producer;
+    bool handled = false;
+    if (req.get_header_value_u64("Content-Length") > 0 || req.has_header("Transfer-Encoding")) {
+        res.status = 413;
+        close = true;
+        handled = true;
+    } else if (pre_routing_handler_) {
+        handled = pre_routing_handler_(req, res) == httplib::Server::HandlerResponse::Handled;
+    }
+    if (handled) {
+    } else if (req.method == "OPTIONS") {
+        res.status = 204;
+    } else if (!route) {
+        res.status = 404;
+    } else if (req.method != "GET" && req.method != "HEAD") {
+        res.status = 405;
+    } else if (route->stream_handler) {
+        producer = route->stream_handler(req, res);
+    } else {
+        route->handler(req, res);
+    }
+    if (res.status == -1) {
+        res.status = 200;
+    }
+
+    conn.out += "HTTP/1.1 " + std::to_string(res.status) + " " + httplib::status_message(res.status) + "\r\n";
+    append_headers(conn.out, res);
+    conn.out += static_headers_;
+    if (producer && res.status == 200) {
+        conn.out += "Cache-Control: no-cache\r\nConnection: close\r\n\r\n";
+        conn.producer = std::move(producer);
+        auto period = route->period;
+        if (req.has_param("period_ms")) {
+            period = std::chrono::milliseconds(std::atoll(req.get_param_value("period_ms").c_str()));
+        }
+        conn.period = std::min(std::max(period, std::chrono::milliseconds(kMinStreamPeriod)), kMaxStreamPeriod);
+        conn.next_push = std::chrono::steady_clock::now();
+        conn.in.clear();
+        return;
+    }
+    conn.out += "Content-Length: " + std::to_string(res.body.size()) + "\r\n";
+    conn.out += close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+    if (req.method != "HEAD") {
+        conn.out += res.body;
+    }
+    conn.close_after_write = close;
+}
+
+void EventLoopServer::push_streams(Loop& loop) {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<int> ready;
+    std::vector<int> idle;
+    bool sweep = now - loop.last_sweep > std::chrono::seconds(1);
+    for (auto& entry : loop.connections) {
+        Connection& conn = *entry.second;
+        if (!conn.producer) {
+            if (sweep && conn.out.empty() && now - conn.last_activity > kIdleTimeout) {
+                idle.push_back(conn.fd);
+            }
+            continue;
+        }
+        if (now < conn.next_push) {
+            continue;
+        }
+        conn.next_push += conn.period;
+        if (conn.next_push < now) {
+            conn.next_push = now + conn.period;
+        }
+        if (conn.out.size() - conn.out_offset > kMaxStreamBacklog) {
+            continue;
+        }
+        std::string bytes = conn.producer();
+        if (!bytes.empty()) {
+            conn.out += bytes;
+            if (!conn.writing) {
+                ready.push_back(conn.fd);
+            }
+        }
+    }
+    if (sweep) {
+        loop.last_sweep = now;
+    }
+    // flush() and close_connection() may erase from the map, so they run
+    // after the walk.
+    for (int fd : ready) {
+        auto it = loop.connections.find(fd);
+        if (it != loop.connections.end()) {
+            flush(loop, *it->second);
+        }
+    }
+    for (int fd : idle) {
+        close_connection(loop, fd);
+    }
+}
+
+bool EventLoopServer::flush(Loop& loop, Connection& conn) {
+    while (conn.out_offset < conn.out.size()) {
+        ssize_t n = ::send(conn.fd, conn.out.data() + conn.out_offset, conn.out.size() - conn.out_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn.out_offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!conn.writing) {
+                conn.writing = true;
+                epoll_set(loop.epoll_fd, EPOLL_CTL_MOD, conn.fd,
+                          conn.peer_closed ? EPOLLOUT : EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+            }
+            return true;
+        }
+        close_connection(loop, conn.fd);
+        return false;
+    }
+    conn.out.clear();
+    conn.out_offset = 0;
+    if (conn.writing) {
+        conn.writing = false;
+        epoll_set(loop.epoll_fd, EPOLL_CTL_MOD, conn.fd, conn.peer_closed ? 0 : EPOLLIN | EPOLLRDHUP);
+    }
+    if (conn.close_after_write) {
+        close_connection(loop, conn.fd);
+        return false;
+    }
+    return true;
+}
+
+void EventLoopServer::close_connection(Loop& loop, int fd) {
+    ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    if (loop.connections.erase(fd)) {
+        connections_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+#else
+
+bool EventLoopServer::listen(const std::string& host, int port) {
+    log_error("event_server.unsupported").field("host", host).field("port", port);
+    return false;
+}
+
+void EventLoopServer::stop() {}
+
+#endif
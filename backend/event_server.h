@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "httplib.h"
+
+// epoll-driven, non-blocking HTTP/1.1 server for read-only telemetry and
+// streaming routes. httplib parks a worker thread on every keep-alive or SSE
+// connection; here a few loop threads multiplex thousands of them. Route
+// handlers use httplib's Handler signature, so the lambdas registered on the
+// httplib::Server can be registered here unchanged.
+//
+// Only GET/HEAD/OPTIONS requests without a body are accepted, and routes are
+// literal paths. Linux only: listen() fails elsewhere.
+class EventLoopServer {
+public:
+    // Per-connection producer polled on every stream tick; returns the next
+    // bytes to send, or an empty string when there is nothing new.
+    using StreamProducer = std::function<std::string()>;
+    // Runs once when a stream request arrives. It sets the response headers
+    // (e.g. Content-Type) and returns the connection's producer, or an empty
+    // function to answer with `res` as a normal response instead.
+    using StreamHandler = std::function<StreamProducer(const httplib::Request&, httplib::Response&)>;
+
+    explicit EventLoopServer(size_t loop_threads);
+    ~EventLoopServer();
+
+    EventLoopServer(const EventLoopServer&) = delete;
+    EventLoopServer& operator=(const EventLoopServer&) = delete;
+
+    void set_pre_routing_handler(httplib::Server::HandlerWithResponse handler);
+    // CRLF-terminated header lines appended verbatim to every response.
+    void set_static_headers(std::string headers) { static_headers_ = std::move(headers); }
+    void Get(const std::string& path, httplib::Server::Handler handler);
+    // Long-lived response whose body is produced incrementally: the producer
+    // returned by `handler` is polled every `period` (or the client's
+    // ?period_ms=) and the body ends when either side closes.
+    void Stream(const std::string& path, StreamHandler handler, std::chrono::milliseconds period);
+
+    // Binds one SO_REUSEPORT listener per loop thread and starts the loops.
+    bool listen(const std::string& host, int port);
+    void stop();
+
+    size_t connection_count() const { return connections_.load(std::memory_order_relaxed); }
+
+private:
+    struct Route;
+    struct Connection;
+    struct Loop;
+
+    void run(Loop& loop);
+    void on_readable(Loop& loop, Connection& conn);
+    void on_request(Connection& conn, const std::string& head);
+    void push_streams(Loop& loop);
+    bool flush(Loop& loop, Connection& conn);
+    void close_connection(Loop& loop, int fd);
+
+    size_t loop_threads_;
+    httplib::Server::HandlerWithResponse pre_routing_handler_;
+    std::string static_headers_;
+    std::unordered_map<std::string, std::unique_ptr<Route>> routes_;
+    std::vector<std::unique_ptr<Loop>> loops_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+    std::atomic<size_t> connections_{0};
+};
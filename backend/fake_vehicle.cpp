@@ -0,0 +1,212 @@
+#include "fake_vehicle.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr double kEarthRadiusM = 6371000.0;
+constexpr double kPi = 3.14159265358979323846;
+constexpr uint32_t kMavCmdNavWaypoint = 16;
+constexpr uint32_t kMavCmdDoChangeSpeed = 178;
+
+double deg_to_rad(double deg) { return deg * kPi / 180.0; }
+double rad_to_deg(double rad) { return rad * 180.0 / kPi; }
+
+}
+
+FakeVehicle::FakeVehicle(FakeVehicleConfig config)
+    : config_(std::move(config)),
+      mavsdk_(mavsdk::Mavsdk::Configuration{mavsdk::ComponentType::Autopilot}),
+      latitude_deg_(config_.home_latitude_deg),
+      longitude_deg_(config_.home_longitude_deg) {}
+
+FakeVehicle::~FakeVehicle() { stop(); }
+
+bool FakeVehicle::start() {
+    auto result = mavsdk_.add_any_connection(config_.connection_url);
+    if (result != mavsdk::ConnectionResult::Success) {
+        std::cerr << "fake vehicle connection failed: " << result << std::endl;
+        return false;
+    }
+    auto server_component = mavsdk_.server_component();
+    telemetry_server_ = std::make_unique<mavsdk::TelemetryServer>(server_component);
+    action_server_ = std::make_unique<mavsdk::ActionServer>(server_component);
+    mission_server_ = std::make_unique<mavsdk::MissionRawServer>(server_component);
+
+    action_server_->set_armable(true, true);
+    action_server_->set_disarmable(true, true);
+    action_server_->set_allow_takeoff(true);
+    action_server_->set_allowable_flight_modes({true, true, true});
+    action_server_->subscribe_arm_disarm(
+        [this](mavsdk::ActionServer::Result, mavsdk::ActionServer::ArmDisarm arm_disarm) {
+            // Like PX4, arming alone does not fly the mission: that waits for
+            // the switch to mission mode that start_mission sends.
+            armed_ = arm_disarm.arm;
+            if (!arm_disarm.arm) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                mission_running_ = false;
+            }
+        });
+    action_server_->subscribe_flight_mode_change(
+        [this](mavsdk::ActionServer::Result, mavsdk::ActionServer::FlightMode mode) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (mode == mavsdk::ActionServer::FlightMode::Mission) {
+                mission_running_ = armed_ && !waypoints_.empty();
+            } else if (mode == mavsdk::ActionServer::FlightMode::Hold) {
+                mission_running_ = false;
+            }
+        });
+    mission_server_->subscribe_incoming_mission(
+        [this](mavsdk::MissionRawServer::Result result, mavsdk::MissionRawServer::MissionPlan plan) {
+            if (result == mavsdk::MissionRawServer::Result::Success) {
+                on_incoming_mission(plan);
+            }
+        });
+    mission_server_->subscribe_clear_all([this](uint32_t) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        waypoints_.clear();
+        current_ = 0;
+        mission_running_ = false;
+    });
+
+    running_ = true;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void FakeVehicle::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+size_t FakeVehicle::mission_size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return waypoints_.size();
+}
+
+size_t FakeVehicle::current_item() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+void FakeVehicle::on_incoming_mission(const mavsdk::MissionRawServer::MissionPlan& plan) {
+    std::vector<Waypoint> waypoints;
+    waypoints.reserve(plan.mission_items.size());
+    float speed_m_s = config_.cruise_speed_m_s;
+    for (const auto& item : plan.mission_items) {
+        if (item.command == kMavCmdDoChangeSpeed && item.param2 > 0.0f) {
+            speed_m_s = item.param2;
+        } else if (item.command == kMavCmdNavWaypoint) {
+            Waypoint waypoint;
+            waypoint.latitude_deg = item.x * 1e-7;
+            waypoint.longitude_deg = item.y * 1e-7;
+            waypoint.relative_altitude_m = item.z;
+            waypoint.speed_m_s = speed_m_s;
+            waypoints.push_back(waypoint);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    waypoints_ = std::move(waypoints);
+    current_ = 0;
+    mission_running_ = false;
+}
+
+void FakeVehicle::run() {
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / config_.telemetry_rate_hz));
+    auto next = std::chrono::steady_clock::now();
+    while (running_) {
+        next += period;
+        step(std::chrono::duration<double>(period).count());
+        publish();
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void FakeVehicle::step(double dt_s) {
+    bool item_reached = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (armed_) {
+            battery_percent_ = std::max(0.0f, battery_percent_ - config_.battery_drain_percent_per_s * static_cast<float>(dt_s));
+        }
+        if (!mission_running_ || current_ >= waypoints_.size()) {
+            north_m_s_ = east_m_s_ = down_m_s_ = 0.0f;
+            return;
+        }
+        const Waypoint& target = waypoints_[current_];
+        const double north_m = deg_to_rad(target.latitude_deg - latitude_deg_) * kEarthRadiusM;
+        const double east_m = deg_to_rad(target.longitude_deg - longitude_deg_) * kEarthRadiusM *
+                              std::cos(deg_to_rad(latitude_deg_));
+        const double up_m = target.relative_altitude_m - relative_altitude_m_;
+        const double distance_m = std::sqrt(north_m * north_m + east_m * east_m + up_m * up_m);
+        const double travel_m = std::min(distance_m, target.speed_m_s * dt_s);
+        if (distance_m > 1e-6) {
+            const double scale = travel_m / distance_m;
+            latitude_deg_ += rad_to_deg(north_m * scale / kEarthRadiusM);
+            longitude_deg_ += rad_to_deg(east_m * scale / (kEarthRadiusM * std::cos(deg_to_rad(latitude_deg_))));
+            relative_altitude_m_ += static_cast<float>(up_m * scale);
+            north_m_s_ = static_cast<float>(north_m * scale / dt_s);
+            east_m_s_ = static_cast<float>(east_m * scale / dt_s);
+            down_m_s_ = static_cast<float>(-up_m * scale / dt_s);
+            if (std::abs(north_m) + std::abs(east_m) > 1e-3) {
+                heading_deg_ = std::fmod(rad_to_deg(std::atan2(east_m, north_m)) + 360.0, 360.0);
+            }
+        }
+        if (distance_m - travel_m <= config_.acceptance_radius_m) {
+            ++current_;
+            item_reached = true;
+            if (current_ >= waypoints_.size()) {
+                mission_running_ = false;
+            }
+        }
+    }
+    if (item_reached) {
+        mission_server_->set_current_item_complete();
+    }
+}
+
+void FakeVehicle::publish() {
+    mavsdk::TelemetryServer::Position position{};
+    mavsdk::TelemetryServer::VelocityNed velocity{};
+    mavsdk::TelemetryServer::Heading heading{};
+    mavsdk::TelemetryServer::Battery battery{};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        position.latitude_deg = latitude_deg_;
+        position.longitude_deg = longitude_deg_;
+        position.relative_altitude_m = relative_altitude_m_;
+        position.absolute_altitude_m = 488.0f + relative_altitude_m_;
+        velocity.north_m_s = north_m_s_;
+        velocity.east_m_s = east_m_s_;
+        velocity.down_m_s = down_m_s_;
+        heading.heading_deg = heading_deg_;
+        battery.remaining_percent = battery_percent_;
+        battery.voltage_v = 42.0f + 8.4f * battery_percent_ / 100.0f;
+    }
+    mavsdk::TelemetryServer::Position home{};
+    home.latitude_deg = config_.home_latitude_deg;
+    home.longitude_deg = config_.home_longitude_deg;
+    home.absolute_altitude_m = 488.0f;
+
+    mavsdk::TelemetryServer::RawGps raw_gps{};
+    raw_gps.latitude_deg = position.latitude_deg;
+    raw_gps.longitude_deg = position.longitude_deg;
+    raw_gps.absolute_altitude_m = position.absolute_altitude_m;
+    mavsdk::TelemetryServer::GpsInfo gps_info{};
+    gps_info.num_satellites = 12;
+    gps_info.fix_type = mavsdk::TelemetryServer::FixType::Fix3D;
+
+    telemetry_server_->publish_home(home);
+    telemetry_server_->publish_raw_gps(raw_gps, gps_info);
+    telemetry_server_->publish_sys_status(battery, true, true, true, true, true);
+    telemetry_server_->publish_extended_sys_state(
+        mavsdk::TelemetryServer::VtolState::Mc,
+        armed_ ? mavsdk::TelemetryServer::LandedState::InAir : mavsdk::TelemetryServer::LandedState::OnGround);
+    telemetry_server_->publish_position(position, velocity, heading);
+    telemetry_server_->publish_battery(battery);
+}
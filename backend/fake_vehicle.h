@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action_server/action_server.h>
+#include <mavsdk/plugins/mission_raw_server/mission_raw_server.h>
+#include <mavsdk/plugins/telemetry_server/telemetry_server.h>
+
+// Lightweight stand-in for PX4 SITL + Gazebo. It runs MAVSDK as an autopilot
+// component, accepts mission uploads and arm commands from the backend, flies
+// the mission kinematically and publishes telemetry at a fixed rate.
+struct FakeVehicleConfig {
+    std::string connection_url = "udpout://127.0.0.1:14550";
+    double home_latitude_deg = 47.397742;
+    double home_longitude_deg = 8.545594;
+    float cruise_speed_m_s = 5.0f;
+    float acceptance_radius_m = 0.5f;
+    double telemetry_rate_hz = 10.0;
+    float battery_drain_percent_per_s = 0.05f;
+};
+
+class FakeVehicle {
+public:
+    explicit FakeVehicle(FakeVehicleConfig config);
+    ~FakeVehicle();
+
+    FakeVehicle(const FakeVehicle&) = delete;
+    FakeVehicle& operator=(const FakeVehicle&) = delete;
+
+    // Opens the MAVLink connection and starts the simulation thread.
+    bool start();
+    void stop();
+
+    bool is_armed() const { return armed_.load(); }
+    size_t mission_size() const;
+    size_t current_item() const;
+
+private:
+    struct Waypoint {
+        double latitude_deg = 0.0;
+        double longitude_deg = 0.0;
+        float relative_altitude_m = 0.0f;
+        float speed_m_s = 0.0f;
+    };
+
+    void on_incoming_mission(const mavsdk::MissionRawServer::MissionPlan& plan);
+    void run();
+    void step(double dt_s);
+    void publish();
+
+    FakeVehicleConfig config_;
+    mavsdk::Mavsdk mavsdk_;
+    std::unique_ptr<mavsdk::TelemetryServer> telemetry_server_;
+    std::unique_ptr<mavsdk::ActionServer> action_server_;
+    std::unique_ptr<mavsdk::MissionRawServer> mission_server_;
+
+    mutable std::mutex mutex_;
+    std::vector<Waypoint> waypoints_;
+    size_t current_ = 0;
+    bool mission_running_ = false;
+    double latitude_deg_ = 0.0;
+    double longitude_deg_ = 0.0;
+    float relative_altitude_m_ = 0.0f;
+    float north_m_s_ = 0.0f;
+    float east_m_s_ = 0.0f;
+    float down_m_s_ = 0.0f;
+    double heading_deg_ = 0.0;
+    float battery_percent_ = 100.0f;
+
+    std::atomic<bool> armed_{false};
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+};
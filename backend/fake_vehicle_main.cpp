@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "fake_vehicle.h"
+
+// Usage: fake_vehicle [--url=udpout://127.0.0.1:14550] [--speed=5] [--rate=10]
+//                     [--home=47.397742,8.545594]
+int main(int argc, char** argv) {
+    FakeVehicleConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg.rfind("--url=", 0) == 0) {
+                config.connection_url = arg.substr(6);
+            } else if (arg.rfind("--speed=", 0) == 0) {
+                config.cruise_speed_m_s = std::stof(arg.substr(8));
+            } else if (arg.rfind("--rate=", 0) == 0) {
+                config.telemetry_rate_hz = std::stod(arg.substr(7));
+            } else if (arg.rfind("--home=", 0) == 0) {
+                auto home = arg.substr(7);
+                auto comma = home.find(',');
+                config.home_latitude_deg = std::stod(home.substr(0, comma));
+                config.home_longitude_deg = std::stod(home.substr(comma + 1));
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid argument '" << arg << "': " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (config.telemetry_rate_hz <= 0.0 || config.cruise_speed_m_s <= 0.0f) {
+        std::cerr << "Speed and telemetry rate must be positive." << std::endl;
+        return 1;
+    }
+
+    FakeVehicle vehicle{config};
+    if (!vehicle.start()) {
+        return 1;
+    }
+    std::cout << "Fake vehicle publishing on " << config.connection_url << " at "
+              << config.telemetry_rate_hz << " Hz, cruise " << config.cruise_speed_m_s << " m/s" << std::endl;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(5));
+        std::cout << "armed=" << vehicle.is_armed() << " item " << vehicle.current_item()
+                  << "/" << vehicle.mission_size() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include "fleet.h"
+
+#include <cstdlib>
+#include "logger.h"
+#include "metrics.h"
+
+std::string mission_plan_json(uint64_t id, const std::vector<mavsdk::Mission::MissionItem>& items) {
+    std::string json;
+    json.reserve(64 + items.size() * 96);
+    json += "{ \"id\": " + std::to_string(id) + ", \"waypoints\": [";
+    for (size_t i = 0; i < items.size(); ++i) {
+        json += i ? ", " : " ";
+        json += "{ \"latitude\": " + std::to_string(items[i].latitude_deg) +
+                ", \"longitude\": " + std::to_string(items[i].longitude_deg) +
+                ", \"relative_altitude_m\": " + std::to_string(items[i].relative_altitude_m) + " }";
+    }
+    json += " ] }";
+    return json;
+}
+
+const std::string& UploadedMission::json() const {
+    std::call_once(json_once_, [this] { json_ = mission_plan_json(id, items); });
+    return json_;
+}
+
+Vehicle::Vehicle(std::shared_ptr<mavsdk::System> system, const DispenserConfig& dispenser_config)
+    : id(system->get_system_id()), system(system), mission(system), action(system), telemetry(system),
+      offboard(system), dispenser(action, dispenser_config) {
+    telemetry.subscribe_position([this](mavsdk::Telemetry::Position position) {
+        store.position.publish({position.latitude_deg, position.longitude_deg});
+    });
+    mission.subscribe_mission_progress([this](mavsdk::Mission::MissionProgress progress) {
+        store.mission_progress.publish({progress.current, progress.total});
+        auto uploaded = uploaded_mission();
+        if (uploaded && !uploaded->flows.empty()) {
+            // Past the last item (mission complete) the pump stops.
+            size_t item = progress.current < 0 ? 0 : static_cast<size_t>(progress.current);
+            dispenser.set_flow(item < uploaded->flows.size() ? uploaded->flows[item] : 0.0);
+        }
+    });
+    telemetry.subscribe_battery([this](mavsdk::Telemetry::Battery battery) {
+        store.battery.publish({battery.remaining_percent, battery.voltage_v});
+    });
+    telemetry.subscribe_altitude([this](mavsdk::Telemetry::Altitude alt) {
+        store.altitude.publish({alt.altitude_relative_m, alt.altitude_amsl_m});
+    });
+    telemetry.subscribe_heading([this](mavsdk::Telemetry::Heading head) {
+        store.heading.publish({head.heading_deg});
+    });
+    telemetry.subscribe_velocity_ned([this](mavsdk::Telemetry::VelocityNed velocity) {
+        dispenser.on_velocity(velocity);
+    });
+}
+
+mavsdk::Mission::Result Vehicle::upload(mavsdk::Mission::MissionPlan plan, uint64_t upload_id,
+                                        std::vector<float> flows) {
+    mavsdk::Mission::Result result = mission.upload_mission(plan);
+    if (result != mavsdk::Mission::Result::Success) {
+        return result;
+    }
+    auto uploaded = std::make_shared<UploadedMission>();
+    uploaded->id = upload_id;
+    uploaded->items = std::move(plan.mission_items);
+    uploaded->flows = std::move(flows);
+    std::lock_guard<std::mutex> lock(uploaded_mission_mutex_);
+    if (!uploaded_mission_ || uploaded_mission_->id < upload_id) {
+        uploaded_mission_ = std::move(uploaded);
+    }
+    return result;
+}
+
+std::shared_ptr<const UploadedMission> Vehicle::uploaded_mission() const {
+    std::lock_guard<std::mutex> lock(uploaded_mission_mutex_);
+    return uploaded_mission_;
+}
+
+Fleet::Fleet(mavsdk::Mavsdk& mavsdk, const DispenserConfig& dispenser_config)
+    : mavsdk_(mavsdk), dispenser_config_(dispenser_config), vehicles_(std::make_shared<const VehicleList>()) {}
+
+Fleet::~Fleet() {
+    if (subscribed_) {
+        mavsdk_.unsubscribe_on_new_system(new_system_handle_);
+    }
+}
+
+void Fleet::start() {
+    new_system_handle_ = mavsdk_.subscribe_on_new_system([this] { scan(); });
+    subscribed_ = true;
+    scan();
+}
+
+void Fleet::scan() {
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    auto current = std::atomic_load(&vehicles_);
+    std::shared_ptr<VehicleList> next;
+    for (const auto& system : mavsdk_.systems()) {
+        if (!system->has_autopilot()) {
+            continue;
+        }
+        uint8_t id = system->get_system_id();
+        bool known = false;
+        for (const auto& vehicle : next ? *next : *current) {
+            known = known || vehicle->id == id;
+        }
+        if (known) {
+            continue;
+        }
+        if (!next) {
+            next = std::make_shared<VehicleList>(*current);
+        }
+        next->push_back(std::make_shared<Vehicle>(system, dispenser_config_));
+        log_info("fleet.vehicle_added").field("id", static_cast<int>(id)).field("vehicles", next->size());
+    }
+    if (next) {
+        std::atomic_store(&vehicles_, std::shared_ptr<const VehicleList>(std::move(next)));
+    }
+}
+
+std::shared_ptr<const Fleet::VehicleList> Fleet::vehicles() const {
+    return std::atomic_load(&vehicles_);
+}
+
+std::shared_ptr<Vehicle> Fleet::find(uint8_t id) const {
+    for (const auto& vehicle : *vehicles()) {
+        if (vehicle->id == id) {
+            return vehicle;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Vehicle> Fleet::find(const std::string& id) const {
+    char* end = nullptr;
+    unsigned long value = std::strtoul(id.c_str(), &end, 10);
+    if (id.empty() || *end != '\0' || value > 255) {
+        return nullptr;
+    }
+    return find(static_cast<uint8_t>(value));
+}
+
+std::string fleet_state_json(const Fleet::VehicleList& vehicles, unsigned fields) {
+    std::string json;
+    json.reserve(32 + vehicles.size() * 480);
+    json += "{ \"vehicles\": [";
+    for (size_t i = 0; i < vehicles.size(); ++i) {
+        Vehicle& vehicle = *vehicles[i];
+        json += i ? ", " : " ";
+        json += "{ \"id\": " + std::to_string(vehicle.id) + ", \"state\": ";
+        json += vehicle.store.state_json(vehicle.store.version(), fields);
+        json += " }";
+    }
+    json += " ] }";
+    return json;
+}
+
+namespace {
+
+// Stats of every vehicle, labelled, taken once so all families agree.
+template <typename Stats, typename Get>
+std::vector<std::pair<std::string, Stats>> vehicle_stats(const Fleet::VehicleList& vehicles, Get get) {
+    std::vector<std::pair<std::string, Stats>> stats;
+    for (const auto& vehicle : vehicles) {
+        stats.emplace_back("vehicle=\"" + std::to_string(vehicle->id) + "\"", get(*vehicle));
+    }
+    return stats;
+}
+
+// The exposition format groups samples by family: HELP and TYPE once, then
+// the family's samples for every vehicle, before the next family starts.
+template <typename Stats>
+void append_counter_family(std::string& out, const std::string& name, const char* help,
+                           const std::vector<std::pair<std::string, Stats>>& stats, uint64_t Stats::*field) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " counter\n";
+    for (const auto& entry : stats) {
+        out += name + "{" + entry.first + "} " + std::to_string(entry.second.*field) + "\n";
+    }
+}
+
+template <typename Stats>
+void append_histogram_family(std::string& out, const std::string& name, const char* help,
+                             const std::vector<std::pair<std::string, Stats>>& stats,
+                             LatencyHistogram::Snapshot Stats::*field) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " histogram\n";
+    for (const auto& entry : stats) {
+        append_prometheus_histogram(out, name, entry.first, entry.second.*field);
+    }
+}
+
+}
+
+std::string fleet_offboard_prometheus(const Fleet::VehicleList& vehicles) {
+    using Stats = OffboardStreamer::Stats;
+    auto stats = vehicle_stats<Stats>(vehicles, [](const Vehicle& vehicle) { return vehicle.offboard_stream.stats(); });
+    std::string out;
+    append_counter_family(out, "foam_offboard_setpoints_total", "Offboard setpoints streamed per vehicle.", stats,
+                          &Stats::setpoints);
+    append_counter_family(out, "foam_offboard_missed_deadlines_total",
+                          "Offboard ticks skipped because the stream thread woke a period late.", stats,
+                          &Stats::missed_deadlines);
+    append_counter_family(out, "foam_offboard_send_failures_total", "Offboard setpoints that could not be sent.",
+                          stats, &Stats::send_failures);
+    append_histogram_family(out, "foam_offboard_lateness_seconds", "Offboard stream wake-up time past its deadline.",
+                            stats, &Stats::lateness);
+    append_histogram_family(out, "foam_offboard_interval_jitter_seconds",
+                            "Deviation of offboard setpoint intervals from the period.", stats,
+                            &Stats::interval_jitter);
+    return out;
+}
+
+std::string fleet_dispenser_prometheus(const Fleet::VehicleList& vehicles) {
+    using Stats = DispenserController::Stats;
+    auto stats = vehicle_stats<Stats>(vehicles, [](const Vehicle& vehicle) { return vehicle.dispenser.stats(); });
+    std::string out;
+    append_counter_family(out, "foam_dispenser_commands_total", "Pump commands sent per vehicle.", stats,
+                          &Stats::commands);
+    append_counter_family(out, "foam_dispenser_stale_ticks_total",
+                          "Dispenser ticks with the pump off because velocity telemetry was stale.", stats,
+                          &Stats::stale_ticks);
+    append_counter_family(out, "foam_dispenser_saturated_ticks_total",
+                          "Dispenser ticks where the pump could not deliver the bead's flow.", stats,
+                          &Stats::saturated_ticks);
+    append_histogram_family(out, "foam_dispenser_latency_seconds",
+                            "Time from a velocity sample arriving to its pump command being queued for sending.",
+                            stats, &Stats::latency);
+    append_histogram_family(out, "foam_dispenser_lateness_seconds", "Dispenser loop wake-up time past its deadline.",
+                            stats, &Stats::lateness);
+    return out;
+}
+
+namespace {
+
+void vehicle_not_found(httplib::Response& res) {
+    res.status = 404;
+    res.set_content("{ \"message\": \"Unknown vehicle.\" }", "application/json");
+}
+
+}
+
+httplib::Server::Handler Fleet::route(Handler handler) const {
+    return [this, handler](const httplib::Request& req, httplib::Response& res) {
+        auto vehicle = req.matches.size() > 1 ? find(req.matches[1].str()) : nullptr;
+        if (!vehicle) {
+            vehicle_not_found(res);
+            return;
+        }
+        handler(*vehicle, req, res);
+    };
+}
+
+httplib::Server::HandlerWithContentReader Fleet::route(HandlerWithContentReader handler) const {
+    return [this, handler](const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& reader) {
+        auto vehicle = req.matches.size() > 1 ? find(req.matches[1].str()) : nullptr;
+        if (!vehicle) {
+            reader([](const char*, size_t) { return true; });
+            vehicle_not_found(res);
+            return;
+        }
+        handler(*vehicle, req, res, reader);
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/mission/mission.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+#include "dispenser.h"
+#include "httplib.h"
+#include "offboard_stream.h"
+#include "telemetry_store.h"
+
+// Mission plan last uploaded to a vehicle, served by /mission. Immutable once
+// built, so its compressed forms can be cached under `id`.
+struct UploadedMission {
+    uint64_t id = 0;
+    std::vector<mavsdk::Mission::MissionItem> items;
+    // Deposition schedule: dispenser flow while flying towards each item.
+    // Empty if the waypoint file had no flow column.
+    std::vector<float> flows;
+
+    // /mission body, built on the first request rather than on the upload
+    // path, which keeps large uploads to one copy of the mission.
+    const std::string& json() const;
+
+private:
+    mutable std::once_flag json_once_;
+    mutable std::string json_;
+};
+
+// JSON body of /mission for the plan uploaded as `id`.
+std::string mission_plan_json(uint64_t id, const std::vector<mavsdk::Mission::MissionItem>& items);
+
+// One autopilot and everything the backend keeps for it. Nothing here is
+// shared between vehicles, so telemetry callbacks and requests for one
+// vehicle never touch another's locks.
+struct Vehicle {
+    Vehicle(std::shared_ptr<mavsdk::System> system, const DispenserConfig& dispenser_config);
+
+    Vehicle(const Vehicle&) = delete;
+    Vehicle& operator=(const Vehicle&) = delete;
+
+    uint8_t id;  // MAVLink system id
+    std::shared_ptr<mavsdk::System> system;
+    mavsdk::Mission mission;
+    mavsdk::Action action;
+    mavsdk::Telemetry telemetry;
+    mavsdk::Offboard offboard;
+    TelemetryStore store;
+    DispenserController dispenser;
+    OffboardStreamer offboard_stream{offboard, dispenser};
+
+    // Uploads `plan`; on success it becomes uploaded_mission() unless a newer
+    // upload (higher `upload_id`) is already stored. Its `flows` then drive
+    // the dispenser from mission progress, one lookup per item reached.
+    mavsdk::Mission::Result upload(mavsdk::Mission::MissionPlan plan, uint64_t upload_id,
+                                   std::vector<float> flows = {});
+    std::shared_ptr<const UploadedMission> uploaded_mission() const;
+
+private:
+    mutable std::mutex uploaded_mission_mutex_;
+    std::shared_ptr<const UploadedMission> uploaded_mission_;
+};
+
+// Registry of connected vehicles. A Vehicle is created, with its own plugin
+// instances and telemetry store, the first time MAVSDK reports a system with
+// an autopilot. The list is copy-on-write: registering a vehicle publishes a
+// new list, and readers take the current one without locking.
+class Fleet {
+public:
+    using VehicleList = std::vector<std::shared_ptr<Vehicle>>;
+    using Handler = std::function<void(Vehicle&, const httplib::Request&, httplib::Response&)>;
+    using HandlerWithContentReader = std::function<void(Vehicle&, const httplib::Request&, httplib::Response&,
+                                                        const httplib::ContentReader&)>;
+
+    Fleet(mavsdk::Mavsdk& mavsdk, const DispenserConfig& dispenser_config);
+    ~Fleet();
+
+    Fleet(const Fleet&) = delete;
+    Fleet& operator=(const Fleet&) = delete;
+
+    // Registers the systems already known and watches for new ones.
+    void start();
+
+    // Fleet-wide id for the next mission upload, so cached plans never collide.
+    uint64_t next_upload_id() { return uploads_.fetch_add(1) + 1; }
+
+    // Vehicles in the order they connected.
+    std::shared_ptr<const VehicleList> vehicles() const;
+    std::shared_ptr<Vehicle> find(uint8_t id) const;
+    // `id` as written in a URL; nullptr if it is not a known system id.
+    std::shared_ptr<Vehicle> find(const std::string& id) const;
+
+    // Adapts a per-vehicle handler to a route whose first capture group is
+    // the vehicle id. Unknown ids get 404; a rejected request's body is
+    // drained so the keep-alive connection stays in sync.
+    httplib::Server::Handler route(Handler handler) const;
+    httplib::Server::HandlerWithContentReader route(HandlerWithContentReader handler) const;
+
+private:
+    void scan();
+
+    mavsdk::Mavsdk& mavsdk_;
+    DispenserConfig dispenser_config_;
+    std::mutex register_mutex_;  // serializes writers only
+    std::shared_ptr<const VehicleList> vehicles_;
+    mavsdk::Mavsdk::NewSystemHandle new_system_handle_;
+    bool subscribed_ = false;
+    std::atomic<uint64_t> uploads_{0};
+};
+
+// Every vehicle's state_json(), limited to `fields`, in one object:
+// { "vehicles": [ { "id": 1, "state": { "seq": ..., ... } }, ... ] }.
+// Each vehicle is read under its own channel locks only.
+std::string fleet_state_json(const Fleet::VehicleList& vehicles, unsigned fields);
+
+// Offboard setpoint counters and timing histograms of every vehicle, in
+// Prometheus text format with a `vehicle` label.
+std::string fleet_offboard_prometheus(const Fleet::VehicleList& vehicles);
+
+// Dispenser command counters and latency histograms of every vehicle, in
+// Prometheus text format with a `vehicle` label.
+std::string fleet_dispenser_prometheus(const Fleet::VehicleList& vehicles);
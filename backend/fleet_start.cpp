@@ -0,0 +1,235 @@
+#include "fleet_start.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <thread>
+#include "logger.h"
+
+namespace {
+
+constexpr size_t kMaxLine = 4096;
+
+// Calls fn(0) .. fn(count - 1) on at most `threads` threads, the caller's
+// included, and returns when all calls have finished.
+template <typename F>
+void run_bounded(size_t count, size_t threads, F fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < std::min(threads, count); ++t) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+// Fills in `message` for vehicles the batch stopped before they failed.
+void mark_stopped(std::vector<VehicleStart>& starts, const char* message) {
+    for (auto& start : starts) {
+        if (start.message.empty()) {
+            start.message = message;
+        }
+    }
+}
+
+}
+
+void FleetMissionParser::feed(const char* data, size_t size) {
+    bytes_ += size;
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* line_end = newline ? newline : end;
+        if (!overlong_) {
+            if (partial_.size() + (line_end - data) > kMaxLine) {
+                overlong_ = true;
+                partial_.clear();
+            } else {
+                partial_.append(data, line_end);
+            }
+        }
+        if (!newline) {
+            return;
+        }
+        if (!overlong_) {
+            line(partial_.data(), partial_.data() + partial_.size());
+        }
+        partial_.clear();
+        overlong_ = false;
+        data = newline + 1;
+    }
+}
+
+void FleetMissionParser::finish() {
+    if (!partial_.empty() && !overlong_) {
+        line(partial_.data(), partial_.data() + partial_.size());
+    }
+    partial_.clear();
+    overlong_ = false;
+    for (auto& parser : parsers_) {
+        parser.second->finish();
+    }
+}
+
+void FleetMissionParser::line(const char* begin, const char* end) {
+    if (begin == end || *begin != '[') {
+        if (current_) {
+            current_->feed(begin, end - begin);
+            current_->feed("\n", 1);
+        }
+        return;
+    }
+    // `partial_` holds the line, so strtoul stops at `end` at the latest.
+    char* close = nullptr;
+    unsigned long id = std::strtoul(begin + 1, &close, 10);
+    if (close == begin + 1 || *close != ']' || id > 255) {
+        if (bad_header_.empty()) {
+            bad_header_.assign(begin, end);
+        }
+        current_ = nullptr;
+        return;
+    }
+    auto& parser = parsers_[static_cast<uint8_t>(id)];
+    if (!parser) {
+        parser = std::make_unique<WaypointParser>();
+        order_.push_back(static_cast<uint8_t>(id));
+    }
+    current_ = parser.get();
+}
+
+std::vector<std::pair<uint8_t, WaypointParser*>> FleetMissionParser::sections() {
+    std::vector<std::pair<uint8_t, WaypointParser*>> sections;
+    for (uint8_t id : order_) {
+        sections.emplace_back(id, parsers_[id].get());
+    }
+    return sections;
+}
+
+bool FleetLauncher::launch(Fleet& fleet, std::vector<VehicleStart>& starts, StartTimings& timings,
+                           std::string& message) {
+    std::atomic<bool> failed{false};
+    run_bounded(starts.size(), upload_threads_, [&](size_t i) {
+        VehicleStart& start = starts[i];
+        mavsdk::Mission::Result result =
+            start.vehicle->upload(std::move(start.plan), fleet.next_upload_id(), std::move(start.flows));
+        start.timings.finish(StartPhase::Upload);
+        if (result != mavsdk::Mission::Result::Success) {
+            log_error("fleet_start.upload_failed").field("vehicle", static_cast<int>(start.vehicle->id))
+                .field("result", result);
+            start.message = "Mission upload failed!";
+            failed = true;
+        }
+    });
+    timings.finish(StartPhase::Upload);
+    if (failed) {
+        mark_stopped(starts, "Not armed: another vehicle's upload failed.");
+        message = "Mission upload failed!";
+        return false;
+    }
+    log_info("fleet_start.uploaded").field("vehicles", starts.size());
+
+    std::vector<char> armed(starts.size(), 0);
+    run_bounded(starts.size(), upload_threads_, [&](size_t i) {
+        VehicleStart& start = starts[i];
+        mavsdk::Action::Result result = start.vehicle->action.arm();
+        start.timings.finish(StartPhase::Arm);
+        if (result != mavsdk::Action::Result::Success) {
+            log_error("fleet_start.arm_failed").field("vehicle", static_cast<int>(start.vehicle->id))
+                .field("result", result);
+            start.message = "Arming failed!";
+            failed = true;
+            return;
+        }
+        armed[i] = 1;
+    });
+    timings.finish(StartPhase::Arm);
+    if (failed) {
+        run_bounded(starts.size(), upload_threads_, [&](size_t i) {
+            if (armed[i]) {
+                starts[i].vehicle->action.disarm();
+            }
+        });
+        mark_stopped(starts, "Disarmed: another vehicle failed to arm.");
+        message = "Arming failed!";
+        return false;
+    }
+    log_info("fleet_start.armed").field("vehicles", starts.size());
+
+    // Go signal: every start command is sent before any acknowledgement is
+    // awaited, so the vehicles start within one MAVLink round trip of each
+    // other instead of one after another.
+    std::vector<std::promise<mavsdk::Mission::Result>> acks(starts.size());
+    std::vector<std::future<mavsdk::Mission::Result>> results;
+    for (auto& ack : acks) {
+        results.push_back(ack.get_future());
+    }
+    for (size_t i = 0; i < starts.size(); ++i) {
+        starts[i].vehicle->mission.start_mission_async([&starts, &acks, i](mavsdk::Mission::Result result) {
+            starts[i].timings.finish(StartPhase::Start);
+            acks[i].set_value(result);
+        });
+    }
+    std::vector<char> started(starts.size(), 0);
+    for (size_t i = 0; i < starts.size(); ++i) {
+        mavsdk::Mission::Result result = results[i].get();
+        if (result != mavsdk::Mission::Result::Success) {
+            log_error("fleet_start.start_failed").field("vehicle", static_cast<int>(starts[i].vehicle->id))
+                .field("result", result);
+            starts[i].message = "Mission start failed!";
+            failed = true;
+        } else {
+            started[i] = 1;
+        }
+    }
+    timings.finish(StartPhase::Start);
+    if (failed) {
+        // The shared timeline the missions were deconflicted against is
+        // broken: hold the vehicles that did start and disarm the rest.
+        run_bounded(starts.size(), upload_threads_, [&](size_t i) {
+            VehicleStart& start = starts[i];
+            if (!started[i]) {
+                start.vehicle->action.disarm();
+                return;
+            }
+            mavsdk::Mission::Result result = start.vehicle->mission.pause_mission();
+            if (result != mavsdk::Mission::Result::Success) {
+                log_error("fleet_start.pause_failed").field("vehicle", static_cast<int>(start.vehicle->id))
+                    .field("result", result);
+                start.message = "Started, and pausing failed after another vehicle failed to start!";
+                return;
+            }
+            start.message = "Paused: another vehicle failed to start.";
+        });
+        message = "Mission start failed!";
+        return false;
+    }
+    for (auto& start : starts) {
+        start.message = "Mission started successfully!";
+    }
+    message = "Mission started successfully!";
+    return true;
+}
+
+std::string fleet_start_json(const std::string& message, const std::vector<VehicleStart>& starts,
+                             const StartTimings& timings) {
+    std::string json = "{ \"message\": \"" + message + "\", \"vehicles\": [";
+    for (size_t i = 0; i < starts.size(); ++i) {
+        const VehicleStart& start = starts[i];
+        json += i ? ", " : " ";
+        json += "{ \"id\": " + std::to_string(start.vehicle->id) +
+                ", \"message\": \"" + start.message + "\"" +
+                ", \"waypoints\": " + std::to_string(start.waypoints) +
+                ", \"timings\": " + start.timings.to_json() + " }";
+    }
+    json += " ], \"timings\": " + timings.to_json() + " }";
+    return json;
+}
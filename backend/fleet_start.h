@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "fleet.h"
+#include "start_timing.h"
+#include "waypoint_parser.h"
+
+// Incremental parser for a /fleet/start body: one waypoint CSV section per
+// vehicle, each opened by a `[<system id>]` line.
+//
+//   [1]
+//   47.397742,8.545594,10
+//   [2]
+//   47.397800,8.545700,10
+//
+// Lines before the first header are ignored.
+class FleetMissionParser {
+public:
+    void feed(const char* data, size_t size);
+    void finish();
+
+    // Sections in the order their first header appeared.
+    std::vector<std::pair<uint8_t, WaypointParser*>> sections();
+    size_t bytes() const { return bytes_; }
+    // Section header that is not a valid system id, if any.
+    const std::string& bad_header() const { return bad_header_; }
+
+private:
+    void line(const char* begin, const char* end);
+
+    std::string partial_;
+    bool overlong_ = false;
+    size_t bytes_ = 0;
+    std::map<uint8_t, std::unique_ptr<WaypointParser>> parsers_;
+    std::vector<uint8_t> order_;
+    WaypointParser* current_ = nullptr;
+    std::string bad_header_;
+};
+
+// Outcome of one vehicle's part of a fleet start.
+struct VehicleStart {
+    std::shared_ptr<Vehicle> vehicle;
+    mavsdk::Mission::MissionPlan plan;  // moved into the upload
+    size_t waypoints = 0;
+    std::vector<float> flows;  // deposition schedule, see WaypointParser::flows()
+    // Phases run back to back from the request's start, so `upload` includes
+    // waiting for a pool slot and `start` includes waiting for the go signal.
+    StartTimings timings;
+    std::string message;
+};
+
+// Starts a mission on several vehicles at once. Uploads run on at most
+// `upload_threads` threads in parallel, so the batch takes about as long as
+// its slowest upload; then every vehicle is armed. Only when all vehicles
+// are armed does the go signal issue start_mission to all of them back to
+// back. A failed upload stops the batch before anything is armed, a failed
+// arm disarms the vehicles that did arm, and a failed start pauses the
+// vehicles that did start (and disarms the others).
+class FleetLauncher {
+public:
+    explicit FleetLauncher(size_t upload_threads) : upload_threads_(upload_threads) {}
+
+    // Returns true if every vehicle started, with the batch message in
+    // `message`, and closes `timings`' phases as the whole batch passes them;
+    // each entry's `message` and `timings` say how far that vehicle got.
+    bool launch(Fleet& fleet, std::vector<VehicleStart>& starts, StartTimings& timings, std::string& message);
+
+private:
+    size_t upload_threads_;
+};
+
+// JSON body of /fleet/start.
+std::string fleet_start_json(const std::string& message, const std::vector<VehicleStart>& starts,
+                             const StartTimings& timings);
@@ -0,0 +1,157 @@
+#include "flight_task_queue.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Shed connections are drained faster than workers serve them (each gets a
+// canned 503), so a small fixed backlog is enough.
+constexpr size_t kShedQueueLimit = 256;
+
+thread_local bool shedding_thread = false;
+
+}
+
+bool pin_current_thread(int cpu) {
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+bool is_shedding_load() { return shedding_thread; }
+
+FlightTaskQueue::FlightTaskQueue(const ServerConfig& config) : max_queued_(config.max_queued_connections) {
+    size_t workers = config.telemetry_threads + config.control_threads;
+    for (size_t i = 0; i < workers; ++i) {
+        int cpu = config.worker_cpus.empty() ? -1 : config.worker_cpus[i % config.worker_cpus.size()];
+        threads_.emplace_back([this, cpu] {
+            if (cpu >= 0) {
+                pin_current_thread(cpu);
+            }
+            work(workers_, false);
+        });
+    }
+    threads_.emplace_back([this] { work(shed_, true); });
+}
+
+FlightTaskQueue::~FlightTaskQueue() { shutdown(); }
+
+bool FlightTaskQueue::enqueue(std::function<void()> fn) {
+    {
+        std::lock_guard<std::mutex> lock(workers_.mutex);
+        if (max_queued_ == 0 || workers_.jobs.size() < max_queued_) {
+            workers_.jobs.push_back(std::move(fn));
+            workers_.cond.notify_one();
+            return true;
+        }
+    }
+    std::lock_guard<std::mutex> lock(shed_.mutex);
+    if (shed_.jobs.size() >= kShedQueueLimit) {
+        return false;
+    }
+    shed_.jobs.push_back(std::move(fn));
+    shed_.cond.notify_one();
+    return true;
+}
+
+void FlightTaskQueue::shutdown() {
+    if (threads_.empty()) {
+        return;
+    }
+    for (Queue* queue : {&workers_, &shed_}) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->shutdown = true;
+        queue->cond.notify_all();
+    }
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+void FlightTaskQueue::work(Queue& queue, bool shedding) {
+    shedding_thread = shedding;
+    for (;;) {
+        std::function<void()> fn;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cond.wait(lock, [&] { return !queue.jobs.empty() || queue.shutdown; });
+            if (queue.jobs.empty()) {
+                break;
+            }
+            fn = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        fn();
+    }
+}
+
+namespace {
+
+// One of a ControlLane's slots, held for the lifetime of a handler call.
+class LaneSlot {
+public:
+    LaneSlot(std::atomic<size_t>& active, size_t capacity)
+        : active_(active), held_(active.fetch_add(1, std::memory_order_acquire) < capacity) {
+        if (!held_) {
+            active_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+    ~LaneSlot() {
+        if (held_) {
+            active_.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    LaneSlot(const LaneSlot&) = delete;
+    LaneSlot& operator=(const LaneSlot&) = delete;
+
+    bool held() const { return held_; }
+
+private:
+    std::atomic<size_t>& active_;
+    bool held_;
+};
+
+void reject_busy(httplib::Response& res) {
+    res.status = 503;
+    res.set_header("Retry-After", "1");
+    res.set_content("Another control command is in progress.", "text/plain");
+}
+
+}
+
+httplib::Server::Handler ControlLane::wrap(httplib::Server::Handler handler) {
+    return [this, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res) {
+        LaneSlot slot(active_, capacity_);
+        if (!slot.held()) {
+            reject_busy(res);
+            return;
+        }
+        handler(req, res);
+    };
+}
+
+httplib::Server::HandlerWithContentReader ControlLane::wrap(httplib::Server::HandlerWithContentReader handler) {
+    return [this, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res,
+                                                const httplib::ContentReader& reader) {
+        LaneSlot slot(active_, capacity_);
+        if (!slot.held()) {
+            reader([](const char*, size_t) { return true; });
+            reject_busy(res);
+            return;
+        }
+        handler(req, res, reader);
+    };
+}
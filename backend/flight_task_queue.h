@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "httplib.h"
+#include "server_config.h"
+
+// Pins the calling thread to `cpu`. Returns false where unsupported.
+bool pin_current_thread(int cpu);
+
+// True while the current thread is answering connections that overflowed the
+// worker queue. The pre-routing handler replies 503 to those immediately.
+bool is_shedding_load();
+
+// httplib task queue for the flight backend: telemetry_threads +
+// control_threads workers (optionally CPU-pinned) behind a bounded queue.
+// Connections that arrive while the queue is full go to a single shedding
+// thread instead of being dropped, so clients get a fast 503 rather than a
+// reset or an unbounded wait.
+class FlightTaskQueue : public httplib::TaskQueue {
+public:
+    explicit FlightTaskQueue(const ServerConfig& config);
+    ~FlightTaskQueue() override;
+
+    bool enqueue(std::function<void()> fn) override;
+    void shutdown() override;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<std::function<void()>> jobs;
+        bool shutdown = false;
+    };
+
+    void work(Queue& queue, bool shedding);
+
+    size_t max_queued_;
+    Queue workers_;
+    Queue shed_;
+    std::vector<std::thread> threads_;
+};
+
+// Caps how many workers long control commands (uploads, deconfliction) may
+// hold at once so they can never starve telemetry polls of threads. Calls
+// beyond the cap are rejected with 503 instead of queueing behind the running
+// command. Safety commands (/abort, /pause, /offboard/stop, /dispenser/flow)
+// stay outside the lane; for a worker that no other client can take, they
+// also have their own listener (ServerConfig::safety_port).
+class ControlLane {
+public:
+    explicit ControlLane(size_t capacity) : capacity_(capacity) {}
+
+    httplib::Server::Handler wrap(httplib::Server::Handler handler);
+    // For streaming-body handlers; a rejected request's body is drained so the
+    // keep-alive connection stays in sync.
+    httplib::Server::HandlerWithContentReader wrap(httplib::Server::HandlerWithContentReader handler);
+
+private:
+    size_t capacity_;
+    std::atomic<size_t> active_{0};
+};
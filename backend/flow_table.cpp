@@ -0,0 +1,67 @@
+#include "flow_table.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+// Lowest command delivering `flow_ml_s`, interpolated along the curve;
+// the top command if the pump cannot reach it.
+double command_for_flow(const std::vector<PumpPoint>& curve, double flow_ml_s) {
+    if (flow_ml_s <= 0.0) {
+        return 0.0;
+    }
+    for (size_t i = 1; i < curve.size(); ++i) {
+        const PumpPoint& a = curve[i - 1];
+        const PumpPoint& b = curve[i];
+        if (b.flow_ml_s >= flow_ml_s && b.flow_ml_s > a.flow_ml_s) {
+            double f = (flow_ml_s - a.flow_ml_s) / (b.flow_ml_s - a.flow_ml_s);
+            return a.command + (b.command - a.command) * std::max(0.0, f);
+        }
+    }
+    return curve.back().command;
+}
+
+}
+
+bool parse_pump_curve(const std::string& value, std::vector<PumpPoint>& curve) {
+    std::vector<PumpPoint> parsed;
+    std::stringstream ss(value);
+    std::string point;
+    while (std::getline(ss, point, ',')) {
+        const char* begin = point.c_str();
+        char* end = nullptr;
+        PumpPoint p;
+        p.command = std::strtod(begin, &end);
+        if (end == begin || *end != ':') {
+            return false;
+        }
+        begin = end + 1;
+        p.flow_ml_s = std::strtod(begin, &end);
+        if (end == begin || *end != '\0' || p.command < 0.0 || p.command > 1.0 || p.flow_ml_s < 0.0) {
+            return false;
+        }
+        if (!parsed.empty() && (p.command <= parsed.back().command || p.flow_ml_s < parsed.back().flow_ml_s)) {
+            return false;
+        }
+        parsed.push_back(p);
+    }
+    if (parsed.size() < 2) {
+        return false;
+    }
+    curve = std::move(parsed);
+    return true;
+}
+
+FlowTable::FlowTable(const DispenserConfig& config)
+    : entries_per_m_s_((kEntries - 1) / config.max_speed_m_s) {
+    double liquid_per_m_ml = config.bead_width_m * config.bead_height_m / config.expansion * 1e6;
+    double max_flow_ml_s = config.pump_curve.back().flow_ml_s;
+    saturation_speed_m_s_ = liquid_per_m_ml > 0.0 ? max_flow_ml_s / liquid_per_m_ml : 0.0;
+    commands_.reserve(kEntries);
+    for (size_t i = 0; i < kEntries; ++i) {
+        double speed = i / entries_per_m_s_;
+        commands_.push_back(static_cast<float>(command_for_flow(config.pump_curve, speed * liquid_per_m_ml)));
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// One measured point of the pump's response: actuator command (0-1) and the
+// liquid flow it delivers.
+struct PumpPoint {
+    double command = 0.0;
+    double flow_ml_s = 0.0;
+};
+
+// What a bead should look like and how the pump gets there. Foam expands
+// after leaving the nozzle, so the liquid needed per metre of bead is its
+// cross-section divided by `expansion`.
+struct DispenserConfig {
+    int actuator = 1;  // MAVLink actuator index driving the pump
+    double bead_width_m = 0.05;
+    double bead_height_m = 0.03;
+    double expansion = 30.0;
+    // Increasing in flow; a flat start models the pump's dead band.
+    std::vector<PumpPoint> pump_curve{{0.0, 0.0}, {0.1, 0.0}, {1.0, 100.0}};
+    double max_speed_m_s = 10.0;  // covered by the lookup table
+    double rate_hz = 50.0;        // control loop
+};
+
+// Parses "command:flow_ml_s,..." (e.g. "0:0,0.1:0,1:100"). Returns false if
+// a point is malformed or flow decreases with command.
+bool parse_pump_curve(const std::string& value, std::vector<PumpPoint>& curve);
+
+// Pump command for every ground speed, precomputed so the control loop does
+// one multiply and one load per tick. Entries are kEntries evenly spaced
+// speeds up to max_speed_m_s; each is the command whose flow, inverted from
+// the pump curve, lays a bead of the configured cross-section at that speed.
+class FlowTable {
+public:
+    static constexpr size_t kEntries = 1024;
+
+    explicit FlowTable(const DispenserConfig& config);
+
+    // Command for `speed_m_s` with the flow scaled by `scale` (1 is the
+    // configured bead, 0 is off). Flow is proportional to speed, so a scaled
+    // bead is the nominal one at a scaled speed.
+    float command(double speed_m_s, double scale = 1.0) const {
+        double index = speed_m_s * scale * entries_per_m_s_ + 0.5;
+        if (!(index > 0.0)) {
+            return 0.0f;
+        }
+        return index >= kEntries ? commands_.back() : commands_[static_cast<size_t>(index)];
+    }
+    // True when the pump cannot deliver the flow: the command is capped at
+    // the top of the curve and the bead comes out thin.
+    bool saturated(double speed_m_s, double scale = 1.0) const { return speed_m_s * scale > saturation_speed_m_s_; }
+
+private:
+    std::vector<float> commands_;
+    double entries_per_m_s_;
+    double saturation_speed_m_s_;
+};
@@ -0,0 +1,306 @@
+#include "gcode_import.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kInch = 0.0254;
+constexpr size_t kOutputFlushBytes = 64 * 1024;
+// Travel moves held back at most; longer runs of travel go to the current layer.
+constexpr size_t kMaxPending = 1024;
+constexpr double kZTolerance = 1e-6;
+
+// Fixed-point decimal without printf: coordinates are formatted millions of
+// times per file.
+void append_fixed(std::string& out, double value, int decimals) {
+    static const int64_t kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    int64_t scale = kPow10[decimals];
+    int64_t scaled = std::llround(std::fabs(value) * scale);
+    if (value < 0.0 && scaled != 0) {
+        out += '-';
+    }
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    int64_t whole = scaled / scale;
+    int64_t fraction = scaled % scale;
+    for (int i = 0; i < decimals; ++i) {
+        *--p = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    *--p = '.';
+    do {
+        *--p = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole);
+    out.append(p, digits + sizeof(digits));
+}
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// G-code number: optional sign, digits, optional fraction. No exponent, since
+// `E` is the extrusion word ("X10E5" is X 10, E 5). Up to 18 significant
+// digits are exact, and the result is one correctly rounded division.
+// Returns `p` if there is no number.
+const char* parse_decimal(const char* p, const char* end, double& value) {
+    static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+    const char* start = p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int fraction_digits = 0;
+    bool any = false;
+    bool overflow = false;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        any = true;
+        if (digits < 18) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            overflow = true;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            any = true;
+            if (digits < 18 && fraction_digits < 18) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                ++fraction_digits;
+            }
+        }
+    }
+    if (!any) {
+        return start;
+    }
+    value = overflow ? 1e18 : static_cast<double>(mantissa) / kPow10[fraction_digits];
+    if (negative) {
+        value = -value;
+    }
+    return p;
+}
+
+}
+
+GcodeImporter::GcodeImporter(const GcodeImportOptions& options, Sink sink, size_t max_line)
+    : options_(options), sink_(std::move(sink)), max_line_(max_line),
+      sin_heading_(std::sin(options.heading_deg * kPi / 180.0)),
+      cos_heading_(std::cos(options.heading_deg * kPi / 180.0)), unit_m_(options.scale_m) {
+    output_.reserve(kOutputFlushBytes + 256);
+}
+
+void GcodeImporter::feed(const char* data, size_t size) {
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        if (newline && partial_.empty() && !overlong_) {
+            // Whole line in this chunk: parse in place; numbers stop at '\n'.
+            if (static_cast<size_t>(newline - data) <= max_line_) {
+                parse_line(data, newline);
+            } else {
+                ++stats_.invalid;
+            }
+            data = newline + 1;
+            continue;
+        }
+        const char* line_end = newline ? newline : end;
+        if (!overlong_) {
+            if (partial_.size() + (line_end - data) > max_line_) {
+                overlong_ = true;
+                partial_.clear();
+            } else {
+                partial_.append(data, line_end);
+            }
+        }
+        if (!newline) {
+            return;
+        }
+        if (overlong_) {
+            ++stats_.invalid;
+        } else {
+            parse_line(partial_.data(), partial_.data() + partial_.size());
+        }
+        partial_.clear();
+        overlong_ = false;
+        data = newline + 1;
+    }
+}
+
+void GcodeImporter::finish() {
+    if (!partial_.empty() && !overlong_) {
+        parse_line(partial_.data(), partial_.data() + partial_.size());
+    }
+    partial_.clear();
+    overlong_ = false;
+    if (!pending_.empty() && layer_ == 0) {
+        layer_ = 1;
+        stats_.layers = 1;
+    }
+    flush_pending();
+    flush_output();
+}
+
+void GcodeImporter::parse_line(const char* begin, const char* end) {
+    ++stats_.lines;
+    const char* comment = static_cast<const char*>(std::memchr(begin, ';', end - begin));
+    if (comment) {
+        end = comment;
+    }
+    int motion = -1;  // 0/1 move, 92 set position, -1 none
+    bool has[4] = {false, false, false, false};  // X Y Z E
+    double value[4] = {0.0, 0.0, 0.0, 0.0};
+    const char* p = begin;
+    while (p < end) {
+        char c = *p;
+        if (is_space(c)) {
+            ++p;
+            continue;
+        }
+        if (c == '(') {
+            const char* close = static_cast<const char*>(std::memchr(p, ')', end - p));
+            p = close ? close + 1 : end;
+            continue;
+        }
+        char letter = static_cast<char>(c >= 'a' && c <= 'z' ? c - 32 : c);
+        double number = 0.0;
+        const char* number_end = parse_decimal(p + 1, end, number);
+        if (number_end == p + 1) {
+            ++stats_.invalid;
+            return;
+        }
+        p = number_end;
+        switch (letter) {
+        case 'G': {
+            int code = static_cast<int>(number);
+            if (code == 0 || code == 1 || code == 92) {
+                motion = code;
+            } else if (code == 2 || code == 3) {
+                ++stats_.unsupported;
+                return;
+            } else if (code == 20) {
+                unit_m_ = options_.scale_m / 0.001 * kInch;
+            } else if (code == 21) {
+                unit_m_ = options_.scale_m;
+            } else if (code == 90) {
+                relative_ = false;
+            } else if (code == 91) {
+                relative_ = true;
+            }
+            break;
+        }
+        case 'M': {
+            int code = static_cast<int>(number);
+            if (code == 82) {
+                relative_e_ = false;
+            } else if (code == 83) {
+                relative_e_ = true;
+            } else if (code == 117 || code == 118) {
+                return;  // display text, not words
+            }
+            break;
+        }
+        case 'X': has[0] = true; value[0] = number; break;
+        case 'Y': has[1] = true; value[1] = number; break;
+        case 'Z': has[2] = true; value[2] = number; break;
+        case 'E': has[3] = true; value[3] = number; break;
+        default: break;  // F, S, T, N...
+        }
+    }
+    if (motion == 92) {
+        double* axes[3] = {&position_.x, &position_.y, &position_.z};
+        for (int i = 0; i < 3; ++i) {
+            if (has[i]) {
+                *axes[i] = value[i] * unit_m_;
+            }
+        }
+        if (has[3]) {
+            e_ = value[3];
+        }
+        return;
+    }
+    if (motion != 0 && motion != 1) {
+        return;
+    }
+    ++stats_.moves;
+    Point to = position_;
+    double* axes[3] = {&to.x, &to.y, &to.z};
+    for (int i = 0; i < 3; ++i) {
+        if (has[i]) {
+            *axes[i] = relative_ ? *axes[i] + value[i] * unit_m_ : value[i] * unit_m_;
+        }
+    }
+    bool extruding = false;
+    if (has[3]) {
+        double advance = relative_e_ ? value[3] : value[3] - e_;
+        e_ = relative_e_ ? e_ + value[3] : value[3];
+        extruding = advance > 0.0;
+    }
+    if (to.x == position_.x && to.y == position_.y && to.z == position_.z) {
+        return;  // retraction, feed rate change...
+    }
+    position_ = to;
+    move(to, extruding);
+}
+
+void GcodeImporter::move(const Point& to, bool extruding) {
+    if (!extruding) {
+        if (layer_ == 0) {
+            pending_.clear();  // before printing starts, only the last travel matters
+        } else if (pending_.size() >= kMaxPending) {
+            flush_pending();
+        }
+        pending_.push_back(to);
+        return;
+    }
+    if (layer_ == 0 || std::fabs(to.z - layer_z_) > kZTolerance) {
+        flush_output();
+        ++layer_;
+        ++stats_.layers;
+        layer_z_ = to.z;
+        flow_written_ = false;
+    }
+    flush_pending();
+    write(to, true);
+}
+
+void GcodeImporter::flush_pending() {
+    for (const auto& point : pending_) {
+        write(point, false);
+    }
+    pending_.clear();
+}
+
+void GcodeImporter::write(const Point& point, bool extruding) {
+    Vec3 local{point.x * cos_heading_ + point.y * sin_heading_, -point.x * sin_heading_ + point.y * cos_heading_, 0.0};
+    double lat_deg = 0.0;
+    double lon_deg = 0.0;
+    options_.origin.to_geodetic(local, lat_deg, lon_deg);
+    append_fixed(output_, lat_deg, 8);
+    output_ += ',';
+    append_fixed(output_, lon_deg, 8);
+    output_ += ',';
+    append_fixed(output_, options_.base_altitude_m + point.z, 3);
+    if (!flow_written_ || extruding != last_flow_) {
+        output_ += extruding ? ",on" : ",off";
+        flow_written_ = true;
+        last_flow_ = extruding;
+    }
+    output_ += '\n';
+    ++stats_.waypoints;
+    if (output_.size() >= kOutputFlushBytes) {
+        flush_output();
+    }
+}
+
+void GcodeImporter::flush_output() {
+    if (!output_.empty()) {
+        sink_(layer_, output_.data(), output_.size());
+        output_.clear();
+    }
+}
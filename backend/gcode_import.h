@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "geo.h"
+
+// Streaming importer for slicer G-code: turns G0/G1 moves into the waypoint
+// CSV WaypointParser reads (`lat,lon,alt,flow`), one layer at a time.
+//
+// Like WaypointParser, feed() takes the file in arbitrary chunks and only a
+// partial line plus a bounded output buffer is ever held, so files of any
+// size import in constant memory.
+//
+// - Position: G90/G91 (absolute/relative), G20/G21 (inch/mm) and G92. X is
+//   east and Y north of `origin` once rotated by heading_deg; Z is height
+//   above base_altitude_m.
+// - Extrusion: M82/M83 (absolute/relative E). A move that advances E
+//   dispenses (`on`); any other move is travel (`off`). The flow field is
+//   written only where it changes, and on each layer's first waypoint.
+// - Layers: a layer starts at the first extruding move at a new Z. The travel
+//   moves leading up to it belong to the new layer, so Z hops between
+//   extrusions do not split layers (a vase-mode spiral, which rises on every
+//   move, does). Travel before the first layer is reduced to its last move.
+// Arcs (G2/G3) are counted as unsupported and skipped.
+struct GcodeImportOptions {
+    GeoOrigin origin;
+    double heading_deg = 0.0;      // direction of the G-code +Y axis, clockwise from north
+    double scale_m = 0.001;        // metres per G-code unit; slicers work in mm
+    double base_altitude_m = 0.0;  // relative altitude of Z = 0
+};
+
+struct GcodeImportStats {
+    size_t lines = 0;
+    size_t moves = 0;
+    size_t waypoints = 0;
+    size_t layers = 0;
+    size_t unsupported = 0;  // arcs
+    size_t invalid = 0;      // words whose number does not parse
+};
+
+class GcodeImporter {
+public:
+    // Receives CSV text for layer `layer` (from 1), in order. A layer's text
+    // may arrive in several calls; the next layer starts after the last one.
+    using Sink = std::function<void(size_t layer, const char* data, size_t size)>;
+
+    GcodeImporter(const GcodeImportOptions& options, Sink sink, size_t max_line = 4096);
+
+    void feed(const char* data, size_t size);
+    // Parses a final unterminated line and flushes everything to the sink.
+    void finish();
+
+    const GcodeImportStats& stats() const { return stats_; }
+
+private:
+    struct Point {
+        double x, y, z;  // metres, build frame
+    };
+
+    void parse_line(const char* begin, const char* end);
+    void move(const Point& to, bool extruding);
+    void write(const Point& point, bool extruding);
+    void flush_pending();
+    void flush_output();
+
+    GcodeImportOptions options_;
+    Sink sink_;
+    size_t max_line_;
+    double sin_heading_;
+    double cos_heading_;
+
+    std::string partial_;
+    bool overlong_ = false;
+
+    // Machine state.
+    Point position_{0.0, 0.0, 0.0};
+    double e_ = 0.0;
+    double unit_m_;  // metres per unit for G20/G21
+    bool relative_ = false;
+    bool relative_e_ = false;
+
+    // Layer state: travel since the last extrusion waits in pending_ until
+    // it is known which layer it leads into.
+    size_t layer_ = 0;
+    double layer_z_ = 0.0;
+    bool flow_written_ = false;
+    bool last_flow_ = false;
+    std::vector<Point> pending_;
+    std::string output_;
+
+    GcodeImportStats stats_;
+};
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "gcode_import.h"
+
+// Usage: gcode_import --origin=47.397742,8.545594 [--heading=0] [--scale=0.001]
+//                     [--base-alt=0] [--out=layer] <file.gcode | ->
+// Writes one waypoint CSV per layer: <out>_0001.csv, <out>_0002.csv, ...
+int main(int argc, char** argv) {
+    GcodeImportOptions options;
+    bool has_origin = false;
+    std::string out = "layer";
+    std::string input;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg.rfind("--origin=", 0) == 0) {
+                auto origin = arg.substr(9);
+                auto comma = origin.find(',');
+                if (comma == std::string::npos) {
+                    throw std::invalid_argument("expected lat,lon");
+                }
+                options.origin.latitude_deg = std::stod(origin.substr(0, comma));
+                options.origin.longitude_deg = std::stod(origin.substr(comma + 1));
+                has_origin = true;
+            } else if (arg.rfind("--heading=", 0) == 0) {
+                options.heading_deg = std::stod(arg.substr(10));
+            } else if (arg.rfind("--scale=", 0) == 0) {
+                options.scale_m = std::stod(arg.substr(8));
+            } else if (arg.rfind("--base-alt=", 0) == 0) {
+                options.base_altitude_m = std::stod(arg.substr(11));
+            } else if (arg.rfind("--out=", 0) == 0) {
+                out = arg.substr(6);
+            } else if (arg.rfind("--", 0) != 0 || arg == "-") {
+                input = arg;
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid argument '" << arg << "': " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (!has_origin || input.empty() || !(options.scale_m > 0.0)) {
+        std::cerr << "usage: gcode_import --origin=lat,lon [--heading=0] [--scale=0.001] [--base-alt=0]"
+                     " [--out=layer] <file.gcode | ->" << std::endl;
+        return 1;
+    }
+    FILE* in = input == "-" ? stdin : std::fopen(input.c_str(), "rb");
+    if (!in) {
+        std::cerr << "Cannot open " << input << std::endl;
+        return 1;
+    }
+
+    FILE* layer_file = nullptr;
+    size_t open_layer = 0;
+    bool write_failed = false;
+    GcodeImporter importer{options, [&](size_t layer, const char* data, size_t size) {
+        if (layer != open_layer) {
+            if (layer_file) {
+                std::fclose(layer_file);
+            }
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%04zu.csv", layer);
+            layer_file = std::fopen((out + name).c_str(), "wb");
+            open_layer = layer;
+        }
+        write_failed = write_failed || !layer_file || std::fwrite(data, 1, size, layer_file) != size;
+    }};
+    std::vector<char> buffer(1 << 20);
+    size_t read;
+    while ((read = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        importer.feed(buffer.data(), read);
+    }
+    importer.finish();
+    if (in != stdin) {
+        std::fclose(in);
+    }
+    if (layer_file && std::fclose(layer_file) != 0) {
+        write_failed = true;
+    }
+    const GcodeImportStats& stats = importer.stats();
+    std::cerr << stats.lines << " lines, " << stats.moves << " moves, " << stats.waypoints << " waypoints in "
+              << stats.layers << " layers (" << stats.unsupported << " arcs skipped, " << stats.invalid
+              << " invalid)" << std::endl;
+    if (write_failed) {
+        std::cerr << "Writing " << out << "_*.csv failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
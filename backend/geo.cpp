@@ -0,0 +1,21 @@
+#include "geo.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr double kEarthRadiusM = 6371000.0;
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+
+}
+
+Vec3 GeoOrigin::to_local(double lat_deg, double lon_deg, double altitude_m) const {
+    return {(lon_deg - longitude_deg) * kDegToRad * kEarthRadiusM * std::cos(latitude_deg * kDegToRad),
+            (lat_deg - latitude_deg) * kDegToRad * kEarthRadiusM, altitude_m};
+}
+
+void GeoOrigin::to_geodetic(const Vec3& local, double& lat_deg, double& lon_deg) const {
+    lat_deg = latitude_deg + local.y / kEarthRadiusM / kDegToRad;
+    lon_deg = longitude_deg + local.x / (kEarthRadiusM * std::cos(latitude_deg * kDegToRad)) / kDegToRad;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+struct Vec3 {
+    double x = 0.0;  // east, m
+    double y = 0.0;  // north, m
+    double z = 0.0;  // up, m
+};
+
+// Local tangent frame around a reference point, accurate to well under a
+// metre across a site a few kilometres wide.
+struct GeoOrigin {
+    double latitude_deg = 0.0;
+    double longitude_deg = 0.0;
+
+    Vec3 to_local(double latitude_deg, double longitude_deg, double altitude_m) const;
+    // Inverse of to_local for the horizontal position.
+    void to_geodetic(const Vec3& local, double& latitude_deg, double& longitude_deg) const;
+};
@@ -0,0 +1,47 @@
+#include "latency_histogram.h"
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snap;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        snap.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        snap.count += snap.counts[i];
+    }
+    snap.sum_us = sum_us_.load(std::memory_order_relaxed);
+    snap.max_us = max_us_.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum_us += other.sum_us;
+    max_us = max_us > other.max_us ? max_us : other.max_us;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile_us(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * count);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return bucket_upper_us(i) < max_us ? bucket_upper_us(i) : max_us;
+        }
+    }
+    return max_us;
+}
+
+std::string LatencyHistogram::Snapshot::to_json() const {
+    return "{ \"count\": " + std::to_string(count) +
+           ", \"mean_us\": " + std::to_string(mean_us()) +
+           ", \"p50_us\": " + std::to_string(percentile_us(0.50)) +
+           ", \"p99_us\": " + std::to_string(percentile_us(0.99)) +
+           ", \"max_us\": " + std::to_string(max_us) + " }";
+}
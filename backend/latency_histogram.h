@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Log2-bucketed latency histogram in microseconds. Bucket i counts samples in
+// [2^(i-1), 2^i) us. Every field is a relaxed atomic, so recording from a
+// MAVSDK callback or an HTTP worker never blocks.
+class LatencyHistogram {
+public:
+    static constexpr size_t kBuckets = 32;
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+
+        double mean_us() const { return count ? static_cast<double>(sum_us) / count : 0.0; }
+        // Upper bound of the bucket holding the q-th quantile (0 < q <= 1).
+        uint64_t percentile_us(double q) const;
+        std::string to_json() const;
+        void merge(const Snapshot& other);
+    };
+
+    void record_us(uint64_t us) {
+        counts_[bucket_for(us)].fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+        uint64_t prev = max_us_.load(std::memory_order_relaxed);
+        while (us > prev && !max_us_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        record_us(us > 0 ? static_cast<uint64_t>(us) : 0);
+    }
+
+    Snapshot snapshot() const;
+
+    static uint64_t bucket_upper_us(size_t bucket) { return bucket == 0 ? 1 : (uint64_t{1} << bucket); }
+
+private:
+    static size_t bucket_for(uint64_t us) {
+        size_t bucket = 0;
+        while (us && bucket < kBuckets - 1) {
+            us >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
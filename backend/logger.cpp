@@ -0,0 +1,200 @@
+#include "logger.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+    }
+    return "unknown";
+}
+
+Logger::Logger(std::FILE* out, std::FILE* err)
+    : slots_(new std::array<Slot, kCapacity>()), out_(out), err_(err) {
+    for (size_t i = 0; i < kCapacity; ++i) {
+        (*slots_)[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread([this] { run(); });
+}
+
+Logger::~Logger() {
+    running_ = false;
+    wake_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+bool Logger::push(const Record& record) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &(*slots_)[pos & (kCapacity - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    std::memcpy(&slot->record, &record, offsetof(Record, text) + record.length);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool Logger::pop(Record& record) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot& slot = (*slots_)[pos & (kCapacity - 1)];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != pos + 1) {
+        return false;
+    }
+    std::memcpy(&record, &slot.record, offsetof(Record, text) + slot.record.length);
+    head_.store(pos + 1, std::memory_order_relaxed);
+    slot.sequence.store(pos + kCapacity, std::memory_order_release);
+    return true;
+}
+
+void Logger::flush() {
+    uint64_t target = pushed_.load(std::memory_order_relaxed);
+    wake_.notify_one();
+    while (written_.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void Logger::run() {
+    Record record;
+    for (;;) {
+        size_t batch = 0;
+        while (pop(record)) {
+            write(record);
+            ++batch;
+        }
+        if (batch > 0) {
+            std::fflush(out_);
+            std::fflush(err_);
+            written_.fetch_add(batch, std::memory_order_release);
+            continue;
+        }
+        if (!running_) {
+            break;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait_for(lock, std::chrono::milliseconds(20));
+    }
+}
+
+void Logger::write(const Record& record) {
+    std::FILE* stream = record.level >= LogLevel::Warn ? err_ : out_;
+    std::fprintf(stream, "ts=%" PRId64 ".%06" PRId64 " level=%s %.*s\n", record.timestamp_us / 1000000,
+                 record.timestamp_us % 1000000, log_level_name(record.level), static_cast<int>(record.length),
+                 record.text);
+}
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+LogLine::LogLine(Logger& logger, LogLevel level, const char* event)
+    : logger_(logger), active_(logger.enabled(level)) {
+    if (!active_) {
+        return;
+    }
+    record_.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch()).count();
+    record_.level = level;
+    record_.length = 0;
+    append("event=", 6);
+    append(event, std::strlen(event));
+}
+
+LogLine::~LogLine() {
+    if (active_) {
+        logger_.push(record_);
+    }
+}
+
+void LogLine::append(const char* text, size_t length) {
+    size_t room = Logger::kRecordSize - record_.length;
+    if (length > room) {
+        length = room;
+    }
+    std::memcpy(record_.text + record_.length, text, length);
+    record_.length = static_cast<uint16_t>(record_.length + length);
+}
+
+void LogLine::append_key(const char* key) {
+    append(" ", 1);
+    append(key, std::strlen(key));
+    append("=", 1);
+}
+
+LogLine& LogLine::field(const char* key, const char* value) {
+    if (!active_) {
+        return *this;
+    }
+    append_key(key);
+    size_t length = std::strlen(value);
+    bool quote = length == 0 || std::strpbrk(value, " =\"") != nullptr;
+    if (!quote) {
+        append(value, length);
+        return *this;
+    }
+    append("\"", 1);
+    for (const char* c = value; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            append("\\", 1);
+        }
+        append(c, 1);
+    }
+    append("\"", 1);
+    return *this;
+}
+
+LogLine& LogLine::field(const char* key, double value) {
+    if (!active_) {
+        return *this;
+    }
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+    append_key(key);
+    append(buffer, static_cast<size_t>(length));
+    return *this;
+}
+
+LogLine& LogLine::field_int(const char* key, int64_t value) {
+    if (!active_) {
+        return *this;
+    }
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    append_key(key);
+    append(buffer, static_cast<size_t>(length));
+    return *this;
+}
+
+LogLine& LogLine::field_uint(const char* key, uint64_t value) {
+    if (!active_) {
+        return *this;
+    }
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%" PRIu64, value);
+    append_key(key);
+    append(buffer, static_cast<size_t>(length));
+    return *this;
+}
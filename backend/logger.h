@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error };
+
+const char* log_level_name(LogLevel level);
+
+// Asynchronous logfmt logger. Callers format into a fixed stack buffer and
+// hand it to a bounded lock-free ring; a background thread does all I/O and
+// flushes once per drained batch. When the ring is full the record is dropped
+// and counted rather than blocking the caller.
+class Logger {
+public:
+    static constexpr size_t kRecordSize = 256;
+    static constexpr size_t kCapacity = 4096;  // power of two
+
+    struct Record {
+        int64_t timestamp_us = 0;
+        LogLevel level = LogLevel::Info;
+        uint16_t length = 0;
+        char text[kRecordSize];
+    };
+
+    Logger(std::FILE* out = stdout, std::FILE* err = stderr);
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    bool enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+    void set_min_level(LogLevel level) { min_level_.store(level, std::memory_order_relaxed); }
+
+    // Never blocks; returns false and bumps dropped() if the ring is full.
+    bool push(const Record& record);
+    // Blocks until everything pushed so far has been written.
+    void flush();
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+
+    bool pop(Record& record);
+    void run();
+    void write(const Record& record);
+
+    std::unique_ptr<std::array<Slot, kCapacity>> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::atomic<LogLevel> min_level_{LogLevel::Info};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<bool> running_{true};
+
+    std::FILE* out_;
+    std::FILE* err_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::thread writer_;
+};
+
+// Process-wide logger used by the backend.
+Logger& logger();
+
+// Builds one structured log line on the stack and submits it on destruction:
+//   log_info("mission.uploaded").field("waypoints", n);
+// emits `ts=... level=info event=mission.uploaded waypoints=42`.
+class LogLine {
+public:
+    LogLine(Logger& logger, LogLevel level, const char* event);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    LogLine& field(const char* key, const char* value);
+    LogLine& field(const char* key, const std::string& value) { return field(key, value.c_str()); }
+    LogLine& field(const char* key, bool value) { return field(key, value ? "true" : "false"); }
+    LogLine& field(const char* key, double value);
+    LogLine& field(const char* key, float value) { return field(key, static_cast<double>(value)); }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, LogLine&>::type field(const char* key, T value) {
+        return std::is_signed<T>::value ? field_int(key, static_cast<int64_t>(value))
+                                        : field_uint(key, static_cast<uint64_t>(value));
+    }
+
+    // Slow path for types that only provide operator<<, e.g. MAVSDK result enums.
+    template <typename T>
+    typename std::enable_if<!std::is_arithmetic<T>::value, LogLine&>::type field(const char* key, const T& value) {
+        if (!active_) {
+            return *this;
+        }
+        std::ostringstream ss;
+        ss << value;
+        return field(key, ss.str());
+    }
+
+private:
+    LogLine& field_int(const char* key, int64_t value);
+    LogLine& field_uint(const char* key, uint64_t value);
+    void append(const char* text, size_t length);
+    void append_key(const char* key);
+
+    Logger& logger_;
+    bool active_;
+    Logger::Record record_;
+};
+
+inline LogLine log_debug(const char* event) { return LogLine(logger(), LogLevel::Debug, event); }
+inline LogLine log_info(const char* event) { return LogLine(logger(), LogLevel::Info, event); }
+inline LogLine log_warn(const char* event) { return LogLine(logger(), LogLevel::Warn, event); }
+inline LogLine log_error(const char* event) { return LogLine(logger(), LogLevel::Error, event); }
@@ -0,0 +1,129 @@
+#include "metrics.h"
+
+#include <chrono>
+#include <exception>
+
+RouteMetrics& Metrics::route(const std::string& path) {
+    auto& entry = routes_[path];
+    if (!entry) {
+        entry = std::make_unique<RouteMetrics>();
+    }
+    return *entry;
+}
+
+namespace {
+
+// Counts a request in flight for its lifetime and records its latency and
+// status class on the way out, also when the handler throws.
+class RequestScope {
+public:
+    RequestScope(RouteMetrics& metrics, const httplib::Response& res)
+        : metrics_(metrics), res_(res), start_(std::chrono::steady_clock::now()),
+          uncaught_(std::uncaught_exceptions()) {
+        metrics_.in_flight.add(1);
+    }
+
+    ~RequestScope() {
+        metrics_.in_flight.add(-1);
+        metrics_.latency.record(std::chrono::steady_clock::now() - start_);
+        // httplib leaves the status at -1 until routing finishes and then
+        // sends 200; a handler that throws becomes a 500.
+        int status = res_.status == -1 ? 200 : res_.status;
+        if (std::uncaught_exceptions() > uncaught_) {
+            status = 500;
+        }
+        size_t status_class = status >= 100 && status < 600 ? status / 100 - 1 : 4;
+        metrics_.responses_by_class[status_class].add(1);
+    }
+
+    RequestScope(const RequestScope&) = delete;
+    RequestScope& operator=(const RequestScope&) = delete;
+
+private:
+    RouteMetrics& metrics_;
+    const httplib::Response& res_;
+    std::chrono::steady_clock::time_point start_;
+    int uncaught_;
+};
+
+}
+
+httplib::Server::Handler Metrics::instrument(const std::string& path, httplib::Server::Handler handler) {
+    RouteMetrics* metrics = &route(path);
+    return [metrics, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res) {
+        RequestScope scope(*metrics, res);
+        handler(req, res);
+    };
+}
+
+httplib::Server::HandlerWithContentReader Metrics::instrument(const std::string& path,
+                                                              httplib::Server::HandlerWithContentReader handler) {
+    RouteMetrics* metrics = &route(path);
+    return [metrics, handler = std::move(handler)](const httplib::Request& req, httplib::Response& res,
+                                                   const httplib::ContentReader& reader) {
+        RequestScope scope(*metrics, res);
+        handler(req, res, reader);
+    };
+}
+
+void append_prometheus_histogram(std::string& out, const std::string& name, const std::string& labels,
+                                 const LatencyHistogram::Snapshot& snapshot) {
+    std::string prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+        cumulative += snapshot.counts[i];
+        out += name + "_bucket{" + prefix + "le=\"" +
+               std::to_string(LatencyHistogram::bucket_upper_us(i) / 1e6) + "\"} " + std::to_string(cumulative) + "\n";
+    }
+    out += name + "_bucket{" + prefix + "le=\"+Inf\"} " + std::to_string(snapshot.count) + "\n";
+    out += name + "_sum{" + labels + "} " + std::to_string(snapshot.sum_us / 1e6) + "\n";
+    out += name + "_count{" + labels + "} " + std::to_string(snapshot.count) + "\n";
+}
+
+std::string Metrics::render_prometheus() const {
+    std::string out;
+    out += "# HELP foam_http_requests_total HTTP responses by route and status class.\n";
+    out += "# TYPE foam_http_requests_total counter\n";
+    for (const auto& route : routes_) {
+        for (size_t i = 0; i < route.second->responses_by_class.size(); ++i) {
+            out += "foam_http_requests_total{route=\"" + route.first + "\",code=\"" + std::to_string(i + 1) +
+                   "xx\"} " + std::to_string(route.second->responses_by_class[i].value()) + "\n";
+        }
+    }
+    out += "# HELP foam_http_in_flight_requests Requests currently inside a route handler.\n";
+    out += "# TYPE foam_http_in_flight_requests gauge\n";
+    for (const auto& route : routes_) {
+        out += "foam_http_in_flight_requests{route=\"" + route.first + "\"} " +
+               std::to_string(route.second->in_flight.value()) + "\n";
+    }
+    out += "# HELP foam_http_request_duration_seconds Handler latency by route.\n";
+    out += "# TYPE foam_http_request_duration_seconds histogram\n";
+    for (const auto& route : routes_) {
+        append_prometheus_histogram(out, "foam_http_request_duration_seconds", "route=\"" + route.first + "\"",
+                                    route.second->latency.snapshot());
+    }
+    out += "# HELP foam_http_queued_connections Accepted connections waiting for a worker thread.\n";
+    out += "# TYPE foam_http_queued_connections gauge\n";
+    out += "foam_http_queued_connections " + std::to_string(queued_connections_.value()) + "\n";
+    out += "# HELP foam_http_rejected_connections_total Connections dropped because the queue was full.\n";
+    out += "# TYPE foam_http_rejected_connections_total counter\n";
+    out += "foam_http_rejected_connections_total " + std::to_string(rejected_connections_.value()) + "\n";
+    out += "# HELP foam_http_shed_requests_total Requests answered 503 because the worker queue was full.\n";
+    out += "# TYPE foam_http_shed_requests_total counter\n";
+    out += "foam_http_shed_requests_total " + std::to_string(shed_requests_.value()) + "\n";
+    return out;
+}
+
+bool InstrumentedTaskQueue::enqueue(std::function<void()> fn) {
+    metrics_.queued_connections().add(1);
+    Metrics& metrics = metrics_;
+    bool queued = inner_->enqueue([&metrics, fn = std::move(fn)] {
+        metrics.queued_connections().add(-1);
+        fn();
+    });
+    if (!queued) {
+        metrics_.queued_connections().add(-1);
+        metrics_.rejected_connections().add(1);
+    }
+    return queued;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include "httplib.h"
+#include "latency_histogram.h"
+#include "sharded_metrics.h"
+
+struct RouteMetrics {
+    std::array<ShardedCounter, 5> responses_by_class;  // 1xx..5xx
+    ShardedCounter in_flight;
+    ShardedHistogram latency;
+};
+
+// Registry of per-route and server-wide metrics. Routes are registered while
+// main() sets up the server; after listen() the map is only read.
+class Metrics {
+public:
+    RouteMetrics& route(const std::string& path);
+
+    // Wraps a route handler so every call is counted and timed under `path`.
+    httplib::Server::Handler instrument(const std::string& path, httplib::Server::Handler handler);
+    httplib::Server::HandlerWithContentReader instrument(const std::string& path,
+                                                         httplib::Server::HandlerWithContentReader handler);
+
+    ShardedCounter& queued_connections() { return queued_connections_; }
+    ShardedCounter& rejected_connections() { return rejected_connections_; }
+    ShardedCounter& shed_requests() { return shed_requests_; }
+
+    // Prometheus text exposition format (version 0.0.4).
+    std::string render_prometheus() const;
+
+private:
+    std::map<std::string, std::unique_ptr<RouteMetrics>> routes_;
+    ShardedCounter queued_connections_;
+    ShardedCounter rejected_connections_;
+    ShardedCounter shed_requests_;
+};
+
+// Appends a Prometheus histogram (buckets in seconds) for one label set.
+void append_prometheus_histogram(std::string& out, const std::string& name, const std::string& labels,
+                                 const LatencyHistogram::Snapshot& snapshot);
+
+// httplib task queue that reports its backlog to Metrics.
+class InstrumentedTaskQueue : public httplib::TaskQueue {
+public:
+    InstrumentedTaskQueue(httplib::TaskQueue* inner, Metrics& metrics) : inner_(inner), metrics_(metrics) {}
+
+    bool enqueue(std::function<void()> fn) override;
+    void shutdown() override { inner_->shutdown(); }
+    void on_idle() override { inner_->on_idle(); }
+
+private:
+    std::unique_ptr<httplib::TaskQueue> inner_;
+    Metrics& metrics_;
+};
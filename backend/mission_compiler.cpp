@@ -0,0 +1,117 @@
+#include "mission_compiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include "geo.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kRadToDeg = 180.0 / kPi;
+
+// Time to fly `length` metres entering at `v_in` and leaving at `v_out`
+// (both reachable within the leg), accelerating at `accel` up to `v_max`.
+double leg_time(double length, double v_in, double v_out, double v_max, double accel) {
+    if (length <= 0.0) {
+        return 0.0;
+    }
+    double v_peak = std::sqrt((2.0 * accel * length + v_in * v_in + v_out * v_out) / 2.0);
+    if (v_peak <= v_max) {
+        return (2.0 * v_peak - v_in - v_out) / accel;
+    }
+    double accel_m = (v_max * v_max - v_in * v_in) / (2.0 * accel);
+    double decel_m = (v_max * v_max - v_out * v_out) / (2.0 * accel);
+    return (2.0 * v_max - v_in - v_out) / accel + (length - accel_m - decel_m) / v_max;
+}
+
+}
+
+std::string MissionCompileReport::to_json() const {
+    return "{ \"fly_through\": " + std::to_string(fly_through) + ", \"stops\": " + std::to_string(stops) +
+           ", \"stop_and_go_s\": " + std::to_string(stop_and_go_s) + ", \"compiled_s\": " + std::to_string(compiled_s) +
+           ", \"saved_s\": " + std::to_string(saved_s()) + " }";
+}
+
+MissionCompileReport compile_mission(std::vector<mavsdk::Mission::MissionItem>& items,
+                                     const MissionCompilerOptions& options) {
+    MissionCompileReport report;
+    size_t n = items.size();
+    if (n == 0) {
+        return report;
+    }
+    GeoOrigin origin{items[0].latitude_deg, items[0].longitude_deg};
+    std::vector<Vec3> points;
+    points.reserve(n);
+    for (const auto& item : items) {
+        points.push_back(origin.to_local(item.latitude_deg, item.longitude_deg, item.relative_altitude_m));
+    }
+    // lengths[i] is leg i: points[i] -> points[i + 1].
+    std::vector<double> lengths(n > 1 ? n - 1 : 0);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        double dx = points[i + 1].x - points[i].x;
+        double dy = points[i + 1].y - points[i].y;
+        double dz = points[i + 1].z - points[i].z;
+        lengths[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+
+    // Speed through each waypoint; the ends and hairpins stop.
+    double cruise = options.cruise_speed_m_s;
+    std::vector<double> through(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        auto& item = items[i];
+        item.is_fly_through = false;
+        if (i == 0 || i + 1 == n) {
+            continue;
+        }
+        double turn_deg = 0.0;
+        double in = lengths[i - 1];
+        double out = lengths[i];
+        if (in > 1e-6 && out > 1e-6) {
+            const Vec3& a = points[i - 1];
+            const Vec3& b = points[i];
+            const Vec3& c = points[i + 1];
+            double cos_turn = ((b.x - a.x) * (c.x - b.x) + (b.y - a.y) * (c.y - b.y) + (b.z - a.z) * (c.z - b.z)) /
+                              (in * out);
+            turn_deg = std::acos(std::max(-1.0, std::min(1.0, cos_turn))) * kRadToDeg;
+        }
+        if (turn_deg >= options.stop_deg) {
+            continue;
+        }
+        item.is_fly_through = true;
+        if (turn_deg < options.straight_deg) {
+            through[i] = cruise;
+            continue;
+        }
+        // Start the turn `radius` before the corner; a fillet tangent to
+        // both legs at that distance has radius r / tan(turn / 2).
+        double radius = std::min(options.max_acceptance_radius_m, 0.4 * std::min(in, out));
+        double fillet = radius / std::tan(turn_deg / kRadToDeg / 2.0);
+        item.acceptance_radius_m = static_cast<float>(radius);
+        through[i] = std::min(cruise, std::sqrt(options.lateral_accel_m_s2 * fillet));
+    }
+    // Forward then backward pass: no waypoint may be entered or left faster
+    // than the neighbouring legs allow accelerating or braking.
+    double accel = options.accel_m_s2;
+    for (size_t i = 1; i < n; ++i) {
+        through[i] = std::min(through[i], std::sqrt(through[i - 1] * through[i - 1] + 2.0 * accel * lengths[i - 1]));
+    }
+    for (size_t i = n - 1; i-- > 0;) {
+        through[i] = std::min(through[i], std::sqrt(through[i + 1] * through[i + 1] + 2.0 * accel * lengths[i]));
+    }
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+        // Cap each leg at the speed it can actually reach.
+        double reachable = std::sqrt((2.0 * accel * lengths[i] + through[i] * through[i] +
+                                      through[i + 1] * through[i + 1]) / 2.0);
+        double leg_speed = std::min(cruise, reachable);
+        if (leg_speed > 0.0) {
+            items[i].speed_m_s = static_cast<float>(leg_speed);
+        }
+        report.stop_and_go_s += leg_time(lengths[i], 0.0, 0.0, cruise, accel);
+        report.compiled_s += leg_time(lengths[i], through[i], through[i + 1], std::max(leg_speed, 1e-9), accel);
+    }
+    for (size_t i = 1; i + 1 < n; ++i) {
+        (items[i].is_fly_through ? report.fly_through : report.stops) += 1;
+    }
+    return report;
+}
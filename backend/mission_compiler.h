@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mavsdk/plugins/mission/mission.h>
+
+// Turns a parsed waypoint list (every point a full stop) into a mission the
+// vehicle can fly through. Each interior waypoint is classified by its turn
+// angle:
+// - nearly straight: fly through at cruise speed;
+// - a real corner: fly through with an acceptance radius that starts the
+//   turn early, at a speed the turn radius allows;
+// - a hairpin: keep the full stop.
+// Leg speeds are also capped so a short leg never asks for more speed than
+// the vehicle can reach and shed again within it.
+struct MissionCompilerOptions {
+    double cruise_speed_m_s = 5.0;
+    double accel_m_s2 = 2.0;          // along-track, for speed caps and estimates
+    double lateral_accel_m_s2 = 2.0;  // in turns
+    double straight_deg = 10.0;       // turns below this keep cruise speed
+    double stop_deg = 120.0;          // turns at or above this stop
+    double max_acceptance_radius_m = 2.0;
+};
+
+struct MissionCompileReport {
+    size_t fly_through = 0;
+    size_t stops = 0;
+    // Estimated flight time from the first to the last waypoint with
+    // trapezoidal speed profiles, as parsed and as compiled.
+    double stop_and_go_s = 0.0;
+    double compiled_s = 0.0;
+
+    double saved_s() const { return stop_and_go_s - compiled_s; }
+    std::string to_json() const;
+};
+
+// Rewrites is_fly_through, acceptance_radius_m and speed_m_s of `items` in place.
+MissionCompileReport compile_mission(std::vector<mavsdk::Mission::MissionItem>& items,
+                                     const MissionCompilerOptions& options = MissionCompilerOptions{});
@@ -0,0 +1,227 @@
+#include "offboard_stream.h"
+
+#include <algorithm>
+#include <cmath>
+#include "logger.h"
+#include "realtime.h"
+
+namespace {
+
+double distance(const NedPoint& a, const NedPoint& b) {
+    return std::sqrt((b.north_m - a.north_m) * (b.north_m - a.north_m) + (b.east_m - a.east_m) * (b.east_m - a.east_m) +
+                     (b.down_m - a.down_m) * (b.down_m - a.down_m));
+}
+
+}
+
+std::vector<NedPoint> mission_path_ned(const std::vector<mavsdk::Mission::MissionItem>& items, const GeoOrigin& here,
+                                       double here_relative_alt_m, const NedPoint& here_ned) {
+    std::vector<NedPoint> path;
+    path.reserve(items.size() + 1);
+    path.push_back(here_ned);
+    for (const auto& item : items) {
+        Vec3 offset = here.to_local(item.latitude_deg, item.longitude_deg, item.relative_altitude_m - here_relative_alt_m);
+        path.push_back({here_ned.north_m + offset.y, here_ned.east_m + offset.x, here_ned.down_m - offset.z});
+    }
+    return path;
+}
+
+OffboardTrajectory::OffboardTrajectory(VelocityProfile profile, const std::vector<NedPoint>& path,
+                                       const std::vector<float>& flows)
+    : path_(std::move(profile.points)), times_(std::move(profile.times)) {
+    size_t legs = path.empty() ? 0 : std::min(flows.size(), path.size() - 1);
+    if (legs == 0 || path_.empty()) {
+        return;
+    }
+    flows_.assign(flows.begin(), flows.begin() + legs);
+    // Distance along the profile at each of its points.
+    std::vector<double> along(path_.size(), 0.0);
+    for (size_t j = 1; j < path_.size(); ++j) {
+        along[j] = along[j - 1] + distance(path_[j - 1], path_[j]);
+    }
+    flow_ends_.reserve(legs);
+    double end = 0.0;
+    size_t at = 1;
+    for (size_t i = 0; i < legs; ++i) {
+        end += distance(path[i], path[i + 1]);
+        if (path_.size() < 2) {
+            flow_ends_.push_back(times_.front());
+            continue;
+        }
+        // The leg ends on the profile's leg from at - 1 to at.
+        while (at + 1 < path_.size() && along[at] < end) {
+            ++at;
+        }
+        double span = along[at] - along[at - 1];
+        double f = span > 0.0 ? std::min(1.0, std::max(0.0, (end - along[at - 1]) / span)) : 1.0;
+        flow_ends_.push_back(times_[at - 1] + (times_[at] - times_[at - 1]) * f);
+    }
+}
+
+float OffboardTrajectory::flow(double t) const {
+    // The first leg still unfinished at t; zero-length legs end as they start.
+    size_t leg = std::upper_bound(flow_ends_.begin(), flow_ends_.end(), t) - flow_ends_.begin();
+    return leg < flows_.size() ? flows_[leg] : 0.0f;
+}
+
+Setpoint OffboardTrajectory::sample(double t) const {
+    Setpoint setpoint;
+    if (path_.empty()) {
+        return setpoint;
+    }
+    if (t <= 0.0 || path_.size() == 1) {
+        setpoint.position = path_.front();
+        return setpoint;
+    }
+    if (t >= times_.back()) {
+        setpoint.position = path_.back();
+        return setpoint;
+    }
+    // First point reached after t; the leg ending there is being flown.
+    size_t next = std::upper_bound(times_.begin(), times_.end(), t) - times_.begin();
+    const NedPoint& a = path_[next - 1];
+    const NedPoint& b = path_[next];
+    double span = times_[next] - times_[next - 1];
+    double f = span > 0.0 ? (t - times_[next - 1]) / span : 1.0;
+    setpoint.position = {a.north_m + (b.north_m - a.north_m) * f, a.east_m + (b.east_m - a.east_m) * f,
+                         a.down_m + (b.down_m - a.down_m) * f};
+    if (span > 0.0) {
+        setpoint.velocity = {(b.north_m - a.north_m) / span, (b.east_m - a.east_m) / span,
+                             (b.down_m - a.down_m) / span};
+    }
+    return setpoint;
+}
+
+OffboardStreamer::~OffboardStreamer() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    halt();
+}
+
+mavsdk::Offboard::Result OffboardStreamer::start(std::shared_ptr<const OffboardTrajectory> trajectory, double rate_hz,
+                                                 double yaw_deg) {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    halt();
+    // PX4 only accepts offboard mode once setpoints are already arriving.
+    Setpoint first = trajectory->sample(0.0);
+    offboard_.set_position_velocity_ned(
+        {static_cast<float>(first.position.north_m), static_cast<float>(first.position.east_m),
+         static_cast<float>(first.position.down_m), static_cast<float>(yaw_deg)},
+        {0.0f, 0.0f, 0.0f, static_cast<float>(yaw_deg)});
+    mavsdk::Offboard::Result result = offboard_.start();
+    if (result != mavsdk::Offboard::Result::Success) {
+        return result;
+    }
+    auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate_hz));
+    period_us_ = static_cast<uint64_t>(period.count() / 1000);
+    duration_ms_ = static_cast<uint64_t>(trajectory->duration_s() * 1000.0);
+    elapsed_ms_ = 0;
+    active_ = true;
+    thread_ = std::thread(&OffboardStreamer::run, this, std::move(trajectory), period, yaw_deg);
+    return result;
+}
+
+mavsdk::Offboard::Result OffboardStreamer::stop() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    bool was_active = active_;
+    halt();
+    return was_active ? offboard_.stop() : mavsdk::Offboard::Result::Success;
+}
+
+void OffboardStreamer::halt() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_requested_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    stop_requested_ = false;
+}
+
+void OffboardStreamer::run(std::shared_ptr<const OffboardTrajectory> trajectory, std::chrono::nanoseconds period,
+                           double yaw_deg) {
+    if (!raise_thread_priority()) {
+        log_warn("offboard.realtime_unavailable");
+    }
+    float yaw = static_cast<float>(yaw_deg);
+    auto started_at = std::chrono::steady_clock::now();
+    auto deadline = started_at + period;
+    auto last_wake = started_at;
+    float flow = -1.0f;  // last flow set, none yet
+    bool finished = false;
+    while (!finished) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (wake_.wait_until(lock, deadline, [this] { return stop_requested_; })) {
+                break;
+            }
+        }
+        auto now = std::chrono::steady_clock::now();
+        lateness_.record(now - deadline);
+        auto interval = now - last_wake;
+        interval_jitter_.record(interval > period ? interval - period : period - interval);
+        last_wake = now;
+
+        // Sample at the actual wake-up time, so a late tick still sends the
+        // position the vehicle should be at now.
+        double t = std::chrono::duration<double>(now - started_at).count();
+        Setpoint setpoint = trajectory->sample(t);
+        auto result = offboard_.set_position_velocity_ned(
+            {static_cast<float>(setpoint.position.north_m), static_cast<float>(setpoint.position.east_m),
+             static_cast<float>(setpoint.position.down_m), yaw},
+            {static_cast<float>(setpoint.velocity.north_m), static_cast<float>(setpoint.velocity.east_m),
+             static_cast<float>(setpoint.velocity.down_m), yaw});
+        if (result != mavsdk::Offboard::Result::Success) {
+            send_failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (trajectory->has_flows()) {
+            float leg_flow = trajectory->flow(t);
+            if (leg_flow != flow) {
+                flow = leg_flow;
+                dispenser_.set_flow(flow);
+            }
+        }
+        setpoints_.fetch_add(1, std::memory_order_relaxed);
+        elapsed_ms_.store(static_cast<uint64_t>(t * 1000.0), std::memory_order_relaxed);
+        finished = t >= trajectory->duration_s();
+
+        deadline += period;
+        // A tick more than a period late is missed, not sent twice.
+        while (deadline <= now) {
+            deadline += period;
+            missed_deadlines_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (trajectory->has_flows()) {
+        dispenser_.set_flow(0.0);
+    }
+    if (finished) {
+        log_info("offboard.finished").field("setpoints", setpoints_.load());
+        offboard_.stop();
+    }
+    active_ = false;
+}
+
+std::string OffboardStreamer::status_json() const {
+    uint64_t period_us = period_us_.load();
+    return "{ \"active\": " + std::string(active_ ? "true" : "false") +
+           ", \"rate_hz\": " + std::to_string(period_us ? 1e6 / period_us : 0.0) +
+           ", \"elapsed_s\": " + std::to_string(elapsed_ms_.load() / 1000.0) +
+           ", \"duration_s\": " + std::to_string(duration_ms_.load() / 1000.0) +
+           ", \"setpoints\": " + std::to_string(setpoints_.load()) +
+           ", \"missed_deadlines\": " + std::to_string(missed_deadlines_.load()) +
+           ", \"send_failures\": " + std::to_string(send_failures_.load()) +
+           ", \"lateness\": " + lateness_.snapshot().to_json() +
+           ", \"interval_jitter\": " + interval_jitter_.snapshot().to_json() + " }";
+}
+
+OffboardStreamer::Stats OffboardStreamer::stats() const {
+    Stats stats;
+    stats.setpoints = setpoints_.load();
+    stats.missed_deadlines = missed_deadlines_.load();
+    stats.send_failures = send_failures_.load();
+    stats.lateness = lateness_.snapshot();
+    stats.interval_jitter = interval_jitter_.snapshot();
+    return stats;
+}
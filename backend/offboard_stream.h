@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mavsdk/plugins/mission/mission.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include "dispenser.h"
+#include "geo.h"
+#include "latency_histogram.h"
+#include "velocity_planner.h"
+
+// Offboard execution of a parsed path: instead of uploading waypoints the
+// vehicle stops at, a dedicated thread streams interpolated position and
+// velocity setpoints at a fixed rate, so the vehicle flies through the path
+// without stopping and the foam bead stays continuous.
+
+struct Setpoint {
+    NedPoint position;
+    NedPoint velocity;
+};
+
+// Mission items as NED points, anchored where the vehicle is now: `here` is
+// its geodetic position and `here_relative_alt_m` its relative altitude, and
+// `here_ned` is the same point in the local frame. The path starts at
+// `here_ned`, so streaming begins from the vehicle's current position.
+std::vector<NedPoint> mission_path_ned(const std::vector<mavsdk::Mission::MissionItem>& items, const GeoOrigin& here,
+                                       double here_relative_alt_m, const NedPoint& here_ned);
+
+// A planned profile as a function of time, interpolated between its points,
+// with the velocity between them as feed-forward. Before 0 and after
+// duration_s() it holds the end points at rest.
+//
+// `flows` is an optional deposition schedule over `path`, the points the
+// profile was planned from: flows[i] is the flow on the leg from path[i] to
+// path[i + 1]. Each leg's end is located on the profile by distance along
+// the path, which resampling preserves, so the schedule becomes a flow per
+// stretch of time.
+class OffboardTrajectory {
+public:
+    explicit OffboardTrajectory(VelocityProfile profile, const std::vector<NedPoint>& path = {},
+                                const std::vector<float>& flows = {});
+
+    double duration_s() const { return times_.empty() ? 0.0 : times_.back(); }
+    size_t points() const { return path_.size(); }
+    Setpoint sample(double t) const;
+    bool has_flows() const { return !flows_.empty(); }
+    // Flow on the leg being flown at t; 0 once the last leg ends.
+    float flow(double t) const;
+
+private:
+    std::vector<NedPoint> path_;
+    std::vector<double> times_;      // arrival time at each point
+    std::vector<float> flows_;       // per leg of the planned-from path
+    std::vector<double> flow_ends_;  // time each of those legs ends
+};
+
+// Streams a trajectory to one vehicle from its own thread. Each tick sleeps
+// until an absolute deadline on the monotonic clock, so timing errors do not
+// accumulate; how late each wake-up was and how far each interval strayed
+// from the period are recorded. The thread asks for SCHED_FIFO where the
+// process is allowed to, and runs at normal priority otherwise. A trajectory
+// with a flow schedule also sets `dispenser`'s flow as it passes each leg,
+// and turns it off when the stream ends or is stopped.
+class OffboardStreamer {
+public:
+    OffboardStreamer(mavsdk::Offboard& offboard, DispenserController& dispenser)
+        : offboard_(offboard), dispenser_(dispenser) {}
+    ~OffboardStreamer();
+
+    OffboardStreamer(const OffboardStreamer&) = delete;
+    OffboardStreamer& operator=(const OffboardStreamer&) = delete;
+
+    // Replaces any running stream: sends the first setpoint, switches the
+    // (already armed) vehicle to offboard and streams `trajectory` at
+    // `rate_hz`. When the trajectory ends the vehicle leaves offboard mode
+    // and holds position.
+    mavsdk::Offboard::Result start(std::shared_ptr<const OffboardTrajectory> trajectory, double rate_hz,
+                                   double yaw_deg);
+    // Ends the stream early and leaves offboard mode. Success if none is running.
+    mavsdk::Offboard::Result stop();
+
+    bool active() const { return active_.load(); }
+    // State of the current or last stream plus the timing histograms.
+    std::string status_json() const;
+    // Setpoint counters and timing histograms for /metrics.
+    struct Stats {
+        uint64_t setpoints = 0;
+        uint64_t missed_deadlines = 0;
+        uint64_t send_failures = 0;
+        LatencyHistogram::Snapshot lateness;
+        LatencyHistogram::Snapshot interval_jitter;
+    };
+    Stats stats() const;
+
+private:
+    void run(std::shared_ptr<const OffboardTrajectory> trajectory, std::chrono::nanoseconds period, double yaw_deg);
+    // Signals the thread and joins it; caller holds control_mutex_.
+    void halt();
+
+    mavsdk::Offboard& offboard_;
+    DispenserController& dispenser_;
+    std::mutex control_mutex_;  // serializes start() and stop()
+    std::thread thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_requested_ = false;
+
+    std::atomic<bool> active_{false};
+    std::atomic<uint64_t> period_us_{0};
+    std::atomic<uint64_t> elapsed_ms_{0};
+    std::atomic<uint64_t> duration_ms_{0};
+    std::atomic<uint64_t> setpoints_{0};
+    std::atomic<uint64_t> missed_deadlines_{0};
+    std::atomic<uint64_t> send_failures_{0};
+    LatencyHistogram lateness_;
+    LatencyHistogram interval_jitter_;
+};
@@ -0,0 +1,6 @@
+#pragma once
+
+// Moves the calling thread to SCHED_FIFO, just above the floor so it never
+// outranks kernel or audio threads. Needs CAP_SYS_NICE or an rtprio limit;
+// returns false (and the thread stays SCHED_OTHER) without one, or off Linux.
+bool raise_thread_priority();
@@ -0,0 +1,222 @@
+#include "response_compression.h"
+
+#include <cstdlib>
+
+#ifdef BACKEND_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef BACKEND_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace {
+
+bool supported(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::Identity: return true;
+#ifdef BACKEND_HAVE_ZLIB
+    case ContentEncoding::Gzip: return true;
+#endif
+#ifdef BACKEND_HAVE_BROTLI
+    case ContentEncoding::Brotli: return true;
+#endif
+    default: return false;
+    }
+}
+
+std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+}
+
+const char* content_encoding_name(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::Gzip: return "gzip";
+    case ContentEncoding::Brotli: return "br";
+    default: return "identity";
+    }
+}
+
+ContentEncoding negotiate_encoding(const std::string& accept_encoding) {
+    // -1 marks a coding the header does not mention.
+    double gzip_q = -1.0;
+    double brotli_q = -1.0;
+    double any_q = -1.0;
+    size_t pos = 0;
+    while (pos <= accept_encoding.size()) {
+        size_t end = accept_encoding.find(',', pos);
+        if (end == std::string::npos) {
+            end = accept_encoding.size();
+        }
+        std::string item = accept_encoding.substr(pos, end - pos);
+        pos = end + 1;
+        double q = 1.0;
+        size_t semicolon = item.find(';');
+        if (semicolon != std::string::npos) {
+            std::string param = trim(item.substr(semicolon + 1));
+            if (param.compare(0, 2, "q=") == 0) {
+                q = std::atof(param.c_str() + 2);
+            }
+            item = item.substr(0, semicolon);
+        }
+        item = trim(item);
+        if (httplib::detail::case_ignore::equal(item, "gzip")) {
+            gzip_q = q;
+        } else if (httplib::detail::case_ignore::equal(item, "br")) {
+            brotli_q = q;
+        } else if (item == "*") {
+            any_q = q;
+        }
+    }
+    if (gzip_q < 0.0) {
+        gzip_q = any_q;
+    }
+    if (brotli_q < 0.0) {
+        brotli_q = any_q;
+    }
+    if (!supported(ContentEncoding::Brotli)) {
+        brotli_q = 0.0;
+    }
+    if (!supported(ContentEncoding::Gzip)) {
+        gzip_q = 0.0;
+    }
+    if (brotli_q > 0.0 && brotli_q >= gzip_q) {
+        return ContentEncoding::Brotli;
+    }
+    if (gzip_q > 0.0) {
+        return ContentEncoding::Gzip;
+    }
+    return ContentEncoding::Identity;
+}
+
+bool compress_body(ContentEncoding encoding, [[maybe_unused]] const std::string& data, [[maybe_unused]] bool effort,
+                   [[maybe_unused]] std::string& out) {
+    switch (encoding) {
+#ifdef BACKEND_HAVE_ZLIB
+    case ContentEncoding::Gzip: {
+        z_stream strm{};
+        // windowBits 31 = 15-bit window with a gzip header.
+        if (deflateInit2(&strm, effort ? 9 : 6, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return false;
+        }
+        out.resize(deflateBound(&strm, static_cast<uLong>(data.size())));
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        strm.avail_in = static_cast<uInt>(data.size());
+        strm.next_out = reinterpret_cast<Bytef*>(&out[0]);
+        strm.avail_out = static_cast<uInt>(out.size());
+        int result = deflate(&strm, Z_FINISH);
+        out.resize(strm.total_out);
+        deflateEnd(&strm);
+        return result == Z_STREAM_END;
+    }
+#endif
+#ifdef BACKEND_HAVE_BROTLI
+    case ContentEncoding::Brotli: {
+        size_t size = BrotliEncoderMaxCompressedSize(data.size());
+        out.resize(size ? size : data.size() + 1024);
+        size = out.size();
+        bool ok = BrotliEncoderCompress(effort ? 9 : 4, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+                                        reinterpret_cast<const uint8_t*>(data.data()), &size,
+                                        reinterpret_cast<uint8_t*>(&out[0])) == BROTLI_TRUE;
+        out.resize(ok ? size : 0);
+        return ok;
+    }
+#endif
+    default:
+        return false;
+    }
+}
+
+ResponseCompressor::ResponseCompressor(size_t min_size, size_t cache_bytes)
+    : min_size_(min_size), cache_bytes_(cache_bytes) {}
+
+ContentEncoding ResponseCompressor::choose(const httplib::Request& req, size_t size) const {
+    if (size < min_size_) {
+        return ContentEncoding::Identity;
+    }
+    return negotiate_encoding(req.get_header_value("Accept-Encoding"));
+}
+
+std::shared_ptr<const std::string> ResponseCompressor::cached(const std::string& key, ContentEncoding encoding,
+                                                              const std::string& body) {
+    std::string full_key = std::string(content_encoding_name(encoding)) + ":" + key;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cache_.find(full_key);
+        if (it != cache_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            cache_hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second.data;
+        }
+    }
+    // Compress outside the lock; two racing misses just both do the work.
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    auto compressed = std::make_shared<std::string>();
+    if (!compress_body(encoding, body, true, *compressed)) {
+        return nullptr;
+    }
+    if (compressed->size() > cache_bytes_) {
+        return compressed;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cache_.count(full_key)) {
+        return compressed;
+    }
+    lru_.push_front(full_key);
+    cache_[full_key] = {compressed, lru_.begin()};
+    cached_bytes_ += compressed->size();
+    while (cached_bytes_ > cache_bytes_) {
+        auto victim = cache_.find(lru_.back());
+        cached_bytes_ -= victim->second.data->size();
+        cache_.erase(victim);
+        lru_.pop_back();
+    }
+    return compressed;
+}
+
+void ResponseCompressor::set_content(httplib::Response& res, const std::string& body, const char* content_type,
+                                     ContentEncoding encoding, const std::string& cache_key) {
+    res.set_header("Vary", "Accept-Encoding");
+    if (encoding != ContentEncoding::Identity) {
+        std::shared_ptr<const std::string> compressed;
+        std::string scratch;
+        if (!cache_key.empty()) {
+            compressed = cached(cache_key, encoding, body);
+        } else if (compress_body(encoding, body, false, scratch)) {
+            compressed = std::make_shared<const std::string>(std::move(scratch));
+        }
+        if (compressed) {
+            bytes_in_.fetch_add(body.size(), std::memory_order_relaxed);
+            bytes_out_.fetch_add(compressed->size(), std::memory_order_relaxed);
+            res.set_header("Content-Encoding", content_encoding_name(encoding));
+            res.set_content(*compressed, content_type);
+            return;
+        }
+    }
+    res.set_content(body, content_type);
+}
+
+void ResponseCompressor::set_content(const httplib::Request& req, httplib::Response& res, const std::string& body,
+                                     const char* content_type, const std::string& cache_key) {
+    set_content(res, body, content_type, choose(req, body.size()), cache_key);
+}
+
+std::string ResponseCompressor::prometheus() const {
+    std::string out;
+    out += "# HELP foam_compression_cache_requests_total Compressed-payload cache lookups by result.\n";
+    out += "# TYPE foam_compression_cache_requests_total counter\n";
+    out += "foam_compression_cache_requests_total{result=\"hit\"} " +
+           std::to_string(cache_hits_.load(std::memory_order_relaxed)) + "\n";
+    out += "foam_compression_cache_requests_total{result=\"miss\"} " +
+           std::to_string(cache_misses_.load(std::memory_order_relaxed)) + "\n";
+    out += "# HELP foam_compression_bytes_total Response bytes before and after compression.\n";
+    out += "# TYPE foam_compression_bytes_total counter\n";
+    out += "foam_compression_bytes_total{stage=\"in\"} " + std::to_string(bytes_in_.load(std::memory_order_relaxed)) + "\n";
+    out += "foam_compression_bytes_total{stage=\"out\"} " + std::to_string(bytes_out_.load(std::memory_order_relaxed)) + "\n";
+    return out;
+}
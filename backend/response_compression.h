@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "httplib.h"
+
+// Negotiated gzip/brotli compression for large responses. httplib's own
+// CPPHTTPLIB_ZLIB_SUPPORT path is left off: it compresses every
+// compressible body, including sub-kilobyte telemetry polls, and would
+// recompress identical payloads for every client. Encoders are available
+// when CMake finds zlib (BACKEND_HAVE_ZLIB) or brotli (BACKEND_HAVE_BROTLI).
+enum class ContentEncoding { Identity, Gzip, Brotli };
+
+// Header token for `encoding` ("identity", "gzip" or "br").
+const char* content_encoding_name(ContentEncoding encoding);
+
+// Best encoding this build supports that Accept-Encoding allows, honouring
+// q-values (q=0 refuses); brotli wins ties. Identity if none.
+ContentEncoding negotiate_encoding(const std::string& accept_encoding);
+
+// Compresses `data` in one shot. Higher `effort` trades CPU for size and is
+// used for cached payloads that are compressed once.
+bool compress_body(ContentEncoding encoding, const std::string& data, bool effort, std::string& out);
+
+class ResponseCompressor {
+public:
+    // Bodies smaller than `min_size` are sent as-is. Up to `cache_bytes` of
+    // compressed immutable payloads are kept, least recently used first out.
+    ResponseCompressor(size_t min_size, size_t cache_bytes);
+
+    // Encoding set_content() will use for a body of `size` bytes.
+    ContentEncoding choose(const httplib::Request& req, size_t size) const;
+
+    // Sets `body` on `res` with `encoding`, adding Content-Encoding and
+    // Vary. A non-empty `cache_key` must identify immutable content; its
+    // compressed form is then reused across requests.
+    void set_content(httplib::Response& res, const std::string& body, const char* content_type,
+                     ContentEncoding encoding, const std::string& cache_key = "");
+    void set_content(const httplib::Request& req, httplib::Response& res, const std::string& body,
+                     const char* content_type, const std::string& cache_key = "");
+
+    // Cache hit/miss counters and compressed byte totals in Prometheus format.
+    std::string prometheus() const;
+
+private:
+    struct CacheEntry {
+        std::shared_ptr<const std::string> data;
+        std::list<std::string>::iterator lru;
+    };
+
+    std::shared_ptr<const std::string> cached(const std::string& key, ContentEncoding encoding,
+                                              const std::string& body);
+
+    size_t min_size_;
+    size_t cache_bytes_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::list<std::string> lru_;  // most recent first
+    size_t cached_bytes_ = 0;
+    std::atomic<uint64_t> cache_hits_{0};
+    std::atomic<uint64_t> cache_misses_{0};
+    std::atomic<uint64_t> bytes_in_{0};
+    std::atomic<uint64_t> bytes_out_{0};
+};
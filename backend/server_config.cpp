@@ -0,0 +1,129 @@
+#include "server_config.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+bool starts_with(const std::string& arg, const char* prefix, std::string& value) {
+    std::string p(prefix);
+    if (arg.compare(0, p.size(), p) != 0) {
+        return false;
+    }
+    value = arg.substr(p.size());
+    return true;
+}
+
+size_t parse_count(const std::string& value, size_t min) {
+    long long parsed = std::stoll(value);
+    if (parsed < static_cast<long long>(min)) {
+        throw std::out_of_range("must be at least " + std::to_string(min));
+    }
+    return static_cast<size_t>(parsed);
+}
+
+double parse_positive(const std::string& value) {
+    double parsed = std::stod(value);
+    if (!(parsed > 0.0)) {
+        throw std::out_of_range("must be positive");
+    }
+    return parsed;
+}
+
+std::vector<int> parse_cpu_list(const std::string& value) {
+    std::vector<int> cpus;
+    std::stringstream ss(value);
+    std::string cpu;
+    while (std::getline(ss, cpu, ',')) {
+        cpus.push_back(static_cast<int>(parse_count(cpu, 0)));
+    }
+    return cpus;
+}
+
+std::vector<std::string> parse_list(const std::string& value) {
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+}
+
+bool parse_server_config(int argc, char** argv, ServerConfig& config, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        try {
+            if (starts_with(arg, "--host=", value)) {
+                config.host = value;
+            } else if (starts_with(arg, "--port=", value)) {
+                config.port = static_cast<int>(parse_count(value, 1));
+            } else if (starts_with(arg, "--telemetry-threads=", value)) {
+                config.telemetry_threads = parse_count(value, 1);
+            } else if (starts_with(arg, "--control-threads=", value)) {
+                config.control_threads = parse_count(value, 1);
+            } else if (starts_with(arg, "--keep-alive-s=", value)) {
+                config.keep_alive_s = parse_count(value, 1);
+            } else if (starts_with(arg, "--safety-port=", value)) {
+                config.safety_port = static_cast<int>(parse_count(value, 0));
+            } else if (starts_with(arg, "--safety-threads=", value)) {
+                config.safety_threads = parse_count(value, 1);
+            } else if (starts_with(arg, "--max-queued=", value)) {
+                config.max_queued_connections = parse_count(value, 0);
+            } else if (starts_with(arg, "--long-poll-slots=", value)) {
+                config.long_poll_slots = parse_count(value, 0);
+            } else if (starts_with(arg, "--stream-port=", value)) {
+                config.stream_port = static_cast<int>(parse_count(value, 0));
+            } else if (starts_with(arg, "--stream-threads=", value)) {
+                config.stream_threads = parse_count(value, 1);
+            } else if (starts_with(arg, "--cors-origins=", value)) {
+                config.cors_origins = parse_list(value);
+            } else if (starts_with(arg, "--compress-min-bytes=", value)) {
+                config.compress_min_bytes = parse_count(value, 0);
+            } else if (starts_with(arg, "--compression-cache-mb=", value)) {
+                config.compression_cache_mb = parse_count(value, 0);
+            } else if (starts_with(arg, "--fleet-upload-threads=", value)) {
+                config.fleet_upload_threads = parse_count(value, 1);
+            } else if (starts_with(arg, "--worker-cpus=", value)) {
+                config.worker_cpus = parse_cpu_list(value);
+            } else if (starts_with(arg, "--dispenser-actuator=", value)) {
+                config.dispenser.actuator = static_cast<int>(parse_count(value, 1));
+            } else if (starts_with(arg, "--dispenser-rate-hz=", value)) {
+                config.dispenser.rate_hz = parse_positive(value);
+            } else if (starts_with(arg, "--bead-width-mm=", value)) {
+                config.dispenser.bead_width_m = parse_positive(value) / 1000.0;
+            } else if (starts_with(arg, "--bead-height-mm=", value)) {
+                config.dispenser.bead_height_m = parse_positive(value) / 1000.0;
+            } else if (starts_with(arg, "--foam-expansion=", value)) {
+                config.dispenser.expansion = parse_positive(value);
+            } else if (starts_with(arg, "--pump-curve=", value)) {
+                if (!parse_pump_curve(value, config.dispenser.pump_curve)) {
+                    throw std::invalid_argument("expected increasing command:flow_ml_s points");
+                }
+            } else {
+                error = "unknown argument '" + arg + "'";
+                return false;
+            }
+        } catch (const std::exception& e) {
+            error = "invalid argument '" + arg + "': " + e.what();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string server_config_usage() {
+    return "usage: backend_flight_module [--host=0.0.0.0] [--port=8080]\n"
+           "       [--telemetry-threads=4] [--control-threads=2] [--keep-alive-s=1] [--max-queued=64]\n"
+           "       [--safety-port=8082] [--safety-threads=2]\n"
+           "       [--long-poll-slots=2] [--stream-port=8081] [--stream-threads=2] [--worker-cpus=2,3]\n"
+           "       [--cors-origins=https://a.example,https://b.example]\n"
+           "       [--compress-min-bytes=1024] [--compression-cache-mb=32] [--fleet-upload-threads=4]\n"
+           "       [--dispenser-actuator=1] [--dispenser-rate-hz=50] [--bead-width-mm=50] [--bead-height-mm=30]\n"
+           "       [--foam-expansion=30] [--pump-curve=0:0,0.1:0,1:100]\n";
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "flow_table.h"
+
+// Runtime settings for the backend's HTTP server, taken from --key=value
+// command-line flags.
+struct ServerConfig {
+    std::string host = "0.0.0.0";
+    int port = 8080;
+    // Workers for the main listener. The pool is shared by every route, and
+    // a keep-alive connection holds its worker between requests; long
+    // control routes (/start, /resume, /fleet/start, /offboard/start...) may
+    // additionally never run on more than control_threads workers at once.
+    size_t telemetry_threads = 4;
+    size_t control_threads = 2;
+    // Idle time after which a keep-alive connection on the main listener is
+    // closed and its worker freed.
+    size_t keep_alive_s = 1;
+    // Listener for the safety commands (/abort, /pause, /offboard/stop,
+    // /dispenser/flow) with its own threads and no keep-alive, so they get a
+    // worker however busy the main listener is. 0 disables it.
+    int safety_port = 8082;
+    size_t safety_threads = 2;
+    // Accepted connections allowed to wait for a worker; beyond this they get
+    // an immediate 503 from a dedicated shedding thread.
+    size_t max_queued_connections = 64;
+    // /state?after= long-polls allowed to hold a worker at once.
+    size_t long_poll_slots = 2;
+    // epoll event-loop server for telemetry and streaming routes; 0 disables it.
+    int stream_port = 8081;
+    size_t stream_threads = 2;
+    // Origins allowed to make cross-origin requests. Empty allows any origin.
+    std::vector<std::string> cors_origins;
+    // Responses at least this large are gzip/brotli-compressed when the
+    // client accepts it; compressed immutable payloads are cached up to the MB cap.
+    size_t compress_min_bytes = 1024;
+    size_t compression_cache_mb = 32;
+    // Mission uploads /fleet/start runs in parallel.
+    size_t fleet_upload_threads = 4;
+    // CPUs the HTTP workers are pinned to, round-robin. Empty disables pinning.
+    std::vector<int> worker_cpus;
+    // Pump actuator, bead geometry and pump curve for every vehicle's dispenser.
+    DispenserConfig dispenser;
+};
+
+// Parses argv into `config`. Returns false and sets `error` on a bad flag.
+bool parse_server_config(int argc, char** argv, ServerConfig& config, std::string& error);
+
+std::string server_config_usage();
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "latency_histogram.h"
+
+// Instrumentation is sharded per thread: each thread writes to its own
+// cache-line-aligned slot with relaxed atomics and /metrics sums the slots on
+// scrape, so hot handlers never contend on a shared counter.
+constexpr size_t kMetricShards = 16;
+
+inline size_t metric_shard() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+class ShardedCounter {
+public:
+    void add(int64_t n = 1) { slots_[metric_shard()].value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const {
+        int64_t total = 0;
+        for (const auto& slot : slots_) {
+            total += slot.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<int64_t> value{0};
+    };
+    std::array<Slot, kMetricShards> slots_;
+};
+
+class ShardedHistogram {
+public:
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> d) { slots_[metric_shard()].histogram.record(d); }
+    LatencyHistogram::Snapshot snapshot() const {
+        LatencyHistogram::Snapshot merged;
+        for (const auto& slot : slots_) {
+            merged.merge(slot.histogram.snapshot());
+        }
+        return merged;
+    }
+
+private:
+    struct alignas(64) Slot {
+        LatencyHistogram histogram;
+    };
+    std::array<Slot, kMetricShards> slots_;
+};
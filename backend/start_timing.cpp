@@ -0,0 +1,56 @@
+#include "start_timing.h"
+#include "metrics.h"
+
+const char* start_phase_name(StartPhase phase) {
+    switch (phase) {
+        case StartPhase::Parse: return "parse";
+        case StartPhase::Compile: return "compile";
+        case StartPhase::Upload: return "upload";
+        case StartPhase::Arm: return "arm";
+        case StartPhase::Start: return "start";
+    }
+    return "unknown";
+}
+
+namespace {
+
+std::string duration_ms_json(std::chrono::steady_clock::duration d) {
+    if (d < std::chrono::steady_clock::duration::zero()) {
+        return "null";
+    }
+    return std::to_string(std::chrono::duration<double, std::milli>(d).count());
+}
+
+}
+
+std::string StartTimings::to_json() const {
+    std::string json = "{ ";
+    for (size_t i = 0; i < kStartPhaseCount; ++i) {
+        json += "\"" + std::string(start_phase_name(static_cast<StartPhase>(i))) + "_ms\": " +
+                duration_ms_json(phases[i]) + ", ";
+    }
+    json += "\"total_ms\": " + duration_ms_json(total()) + " }";
+    return json;
+}
+
+void StartPhaseMetrics::record(const StartTimings& timings) {
+    for (size_t i = 0; i < kStartPhaseCount; ++i) {
+        if (timings.phases[i] >= std::chrono::steady_clock::duration::zero()) {
+            phases_[i].record(timings.phases[i]);
+        }
+    }
+    total_.record(timings.total());
+}
+
+std::string StartPhaseMetrics::prometheus() const {
+    std::string out;
+    out += "# HELP foam_start_phase_duration_seconds Duration of each /start pipeline phase.\n";
+    out += "# TYPE foam_start_phase_duration_seconds histogram\n";
+    for (size_t i = 0; i < kStartPhaseCount; ++i) {
+        append_prometheus_histogram(out, "foam_start_phase_duration_seconds",
+                                    "phase=\"" + std::string(start_phase_name(static_cast<StartPhase>(i))) + "\"",
+                                    phases_[i].snapshot());
+    }
+    append_prometheus_histogram(out, "foam_start_phase_duration_seconds", "phase=\"total\"", total_.snapshot());
+    return out;
+}
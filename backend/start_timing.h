@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include "sharded_metrics.h"
+
+// Phases of the /start pipeline, in execution order. Compile only runs when
+// the mission is compiled (the default, see compile_mission).
+enum class StartPhase { Parse, Compile, Upload, Arm, Start };
+constexpr size_t kStartPhaseCount = 5;
+
+const char* start_phase_name(StartPhase phase);
+
+// Monotonic per-phase breakdown of one /start request. Phases that never ran
+// (because an earlier one failed) stay negative and serialize as null.
+struct StartTimings {
+    std::array<std::chrono::steady_clock::duration, kStartPhaseCount> phases;
+    std::chrono::steady_clock::time_point started_at = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point phase_started_at = started_at;
+
+    StartTimings() { phases.fill(std::chrono::steady_clock::duration{-1}); }
+
+    // Closes `phase` at the current time and opens the next one.
+    void finish(StartPhase phase) {
+        auto now = std::chrono::steady_clock::now();
+        phases[static_cast<size_t>(phase)] = now - phase_started_at;
+        phase_started_at = now;
+    }
+
+    std::chrono::steady_clock::duration total() const { return phase_started_at - started_at; }
+    std::string to_json() const;
+};
+
+// Histograms of every phase across all /start requests.
+class StartPhaseMetrics {
+public:
+    void record(const StartTimings& timings);
+    std::string prometheus() const;
+
+private:
+    std::array<ShardedHistogram, kStartPhaseCount> phases_;
+    ShardedHistogram total_;
+};
@@ -0,0 +1,114 @@
+#include "static_router.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// FNV-1a with the seed folded into the offset basis.
+uint64_t path_hash(const std::string& path, uint64_t seed) {
+    uint64_t hash = 14695981039346656037ull ^ (seed * 0x9e3779b97f4a7c15ull);
+    for (unsigned char c : path) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // FNV's low bits mix poorly for short keys; fold the high half in.
+    return hash ^ (hash >> 29);
+}
+
+uint64_t next_pow2(uint64_t n) {
+    uint64_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+}
+
+void StaticRouter::Get(const std::string& path, httplib::Server::Handler handler) {
+    for (const auto& entry : entries_) {
+        if (entry.path == path) {
+            throw std::invalid_argument("duplicate route " + path);
+        }
+    }
+    entries_.push_back({path, std::move(handler)});
+}
+
+void StaticRouter::build() {
+    uint64_t buckets = next_pow2(std::max<uint64_t>(entries_.size() / 2, 1));
+    uint64_t slots = next_pow2(std::max<uint64_t>(entries_.size() * 2, 8));
+    bucket_mask_ = buckets - 1;
+    slot_mask_ = slots - 1;
+    seeds_.assign(buckets, 0);
+    slots_.assign(slots, -1);
+
+    std::vector<std::vector<int32_t>> members(buckets);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        members[path_hash(entries_[i].path, 0) & bucket_mask_].push_back(static_cast<int32_t>(i));
+    }
+    std::vector<uint64_t> order(buckets);
+    for (uint64_t b = 0; b < buckets; ++b) {
+        order[b] = b;
+    }
+    // Place crowded buckets first, while most slots are still free.
+    std::sort(order.begin(), order.end(), [&](uint64_t a, uint64_t b) {
+        return members[a].size() > members[b].size();
+    });
+
+    std::vector<uint64_t> placed;
+    for (uint64_t bucket : order) {
+        if (members[bucket].empty()) {
+            break;
+        }
+        for (uint32_t seed = 1;; ++seed) {
+            if (seed == 0) {
+                throw std::runtime_error("static router: no perfect hash found");
+            }
+            placed.clear();
+            for (int32_t index : members[bucket]) {
+                uint64_t slot = path_hash(entries_[index].path, seed) & slot_mask_;
+                if (slots_[slot] != -1 || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                    break;
+                }
+                placed.push_back(slot);
+            }
+            if (placed.size() == members[bucket].size()) {
+                for (size_t i = 0; i < placed.size(); ++i) {
+                    slots_[placed[i]] = members[bucket][i];
+                }
+                seeds_[bucket] = seed;
+                break;
+            }
+        }
+    }
+}
+
+const httplib::Server::Handler* StaticRouter::find(const std::string& path) const {
+    if (seeds_.empty()) {
+        return nullptr;
+    }
+    uint32_t seed = seeds_[path_hash(path, 0) & bucket_mask_];
+    if (seed == 0) {
+        return nullptr;
+    }
+    int32_t index = slots_[path_hash(path, seed) & slot_mask_];
+    if (index < 0 || entries_[index].path != path) {
+        return nullptr;
+    }
+    return &entries_[index].handler;
+}
+
+httplib::Server::HandlerResponse StaticRouter::dispatch(const httplib::Request& req, httplib::Response& res) const {
+    // A body has not been read yet at pre-routing time; leave such requests
+    // to httplib so the connection stays in sync.
+    if ((req.method != "GET" && req.method != "HEAD") || httplib::detail::expect_content(req)) {
+        return httplib::Server::HandlerResponse::Unhandled;
+    }
+    const auto* handler = find(req.path);
+    if (!handler) {
+        return httplib::Server::HandlerResponse::Unhandled;
+    }
+    (*handler)(req, res);
+    return httplib::Server::HandlerResponse::Handled;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "httplib.h"
+
+// Exact-match dispatch for literal GET routes, run from the pre-routing
+// handler. httplib tries every registered std::regex in order, so the cost
+// of /telemetry grows with each endpoint added; here lookup is two hashes
+// and one string compare regardless of route count. Routes with path
+// parameters, and anything that carries a body, stay on httplib's router.
+//
+// The table is a hash-and-displace perfect hash built once by build(): keys
+// are grouped into buckets by one hash, and each bucket stores the seed of
+// a second hash that places all of its keys in distinct slots.
+class StaticRouter {
+public:
+    // Registers a literal path for GET and HEAD. Must precede build().
+    void Get(const std::string& path, httplib::Server::Handler handler);
+    void build();
+
+    // Runs the matching handler and returns Handled, or Unhandled to let
+    // httplib route the request.
+    httplib::Server::HandlerResponse dispatch(const httplib::Request& req, httplib::Response& res) const;
+
+    // Handler registered for `path`, or nullptr.
+    const httplib::Server::Handler* find(const std::string& path) const;
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::string path;
+        httplib::Server::Handler handler;
+    };
+
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> seeds_;  // per bucket
+    std::vector<int32_t> slots_;   // entry index, or -1
+    uint64_t bucket_mask_ = 0;
+    uint64_t slot_mask_ = 0;
+};
@@ -0,0 +1,112 @@
+#include "telemetry_frame.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+
+template <typename Int>
+Int scaled(double value, double scale) {
+    double v = std::round(value * scale);
+    if (!(v >= std::numeric_limits<Int>::min())) {
+        return std::numeric_limits<Int>::min();
+    }
+    if (v > std::numeric_limits<Int>::max()) {
+        return std::numeric_limits<Int>::max();
+    }
+    return static_cast<Int>(v);
+}
+
+void put_u16(uint8_t* out, uint16_t v) {
+    out[0] = static_cast<uint8_t>(v);
+    out[1] = static_cast<uint8_t>(v >> 8);
+}
+
+void put_u32(uint8_t* out, uint32_t v) {
+    put_u16(out, static_cast<uint16_t>(v));
+    put_u16(out + 2, static_cast<uint16_t>(v >> 16));
+}
+
+uint16_t get_u16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    return get_u16(in) | (static_cast<uint32_t>(get_u16(in + 2)) << 16);
+}
+
+}
+
+int32_t scale_degrees_e7(double degrees) {
+    return scaled<int32_t>(degrees, 1e7);
+}
+
+int16_t scale_altitude_dm(float metres) {
+    return scaled<int16_t>(metres, 10.0);
+}
+
+int16_t scale_heading_cdeg(double degrees) {
+    double deg = std::fmod(degrees + 180.0, 360.0);
+    if (deg < 0.0) {
+        deg += 360.0;
+    }
+    return static_cast<int16_t>(static_cast<int>(std::round(deg * 100.0)) % 36000 - 18000);
+}
+
+uint8_t scale_battery_percent(float percent) {
+    return scaled<uint8_t>(percent, 1.0);
+}
+
+TelemetryFrame make_frame(TelemetryStore& store, uint64_t seq) {
+    TelemetryFrame frame;
+    frame.seq = static_cast<uint32_t>(seq);
+    auto position = store.position.read();
+    if (position.valid()) {
+        frame.valid |= kFramePosition;
+        frame.latitude_e7 = scale_degrees_e7(position.value.latitude);
+        frame.longitude_e7 = scale_degrees_e7(position.value.longitude);
+    }
+    auto altitude = store.altitude.read();
+    if (altitude.valid()) {
+        frame.valid |= kFrameAltitude;
+        frame.altitude_dm = scale_altitude_dm(altitude.value.relative_altitude_m);
+    }
+    auto heading = store.heading.read();
+    if (heading.valid()) {
+        frame.valid |= kFrameHeading;
+        frame.heading_cdeg = scale_heading_cdeg(heading.value.heading_deg);
+    }
+    auto battery = store.battery.read();
+    if (battery.valid()) {
+        frame.valid |= kFrameBattery;
+        frame.battery_percent = scale_battery_percent(battery.value.remaining_percent);
+    }
+    return frame;
+}
+
+FrameBytes encode_frame(const TelemetryFrame& frame) {
+    FrameBytes out{};
+    out[0] = kFrameVersion;
+    out[1] = frame.valid;
+    put_u32(&out[2], frame.seq);
+    put_u32(&out[6], static_cast<uint32_t>(frame.latitude_e7));
+    put_u32(&out[10], static_cast<uint32_t>(frame.longitude_e7));
+    put_u16(&out[14], static_cast<uint16_t>(frame.altitude_dm));
+    put_u16(&out[16], static_cast<uint16_t>(frame.heading_cdeg));
+    out[18] = frame.battery_percent;
+    return out;
+}
+
+bool decode_frame(const uint8_t* data, size_t size, TelemetryFrame& frame) {
+    if (size != kFrameSize || data[0] != kFrameVersion) {
+        return false;
+    }
+    frame.valid = data[1];
+    frame.seq = get_u32(&data[2]);
+    frame.latitude_e7 = static_cast<int32_t>(get_u32(&data[6]));
+    frame.longitude_e7 = static_cast<int32_t>(get_u32(&data[10]));
+    frame.altitude_dm = static_cast<int16_t>(get_u16(&data[14]));
+    frame.heading_cdeg = static_cast<int16_t>(get_u16(&data[16]));
+    frame.battery_percent = data[18];
+    return true;
+}
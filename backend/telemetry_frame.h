@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "telemetry_store.h"
+
+// Fixed-layout binary snapshot of the vehicle state for bandwidth-starved
+// links, served instead of /state JSON when the client sends
+// Accept: application/octet-stream. All fields are little-endian:
+//
+//   offset size  field
+//        0    1  format version (kFrameVersion)
+//        1    1  valid mask: bit n set once channel n has a sample
+//                (0 position, 1 altitude, 2 heading, 3 battery)
+//        2    4  uint32 seq, the store version, truncated
+//        6    4  int32 latitude, degrees * 1e7
+//       10    4  int32 longitude, degrees * 1e7
+//       14    2  int16 relative altitude, decimetres (+-3276.7 m)
+//       16    2  int16 heading, centidegrees in [-18000, 18000)
+//       18    1  uint8 battery remaining, percent
+constexpr uint8_t kFrameVersion = 1;
+constexpr size_t kFrameSize = 19;
+
+using FrameBytes = std::array<uint8_t, kFrameSize>;
+
+enum FrameValid : uint8_t {
+    kFramePosition = 1 << 0,
+    kFrameAltitude = 1 << 1,
+    kFrameHeading = 1 << 2,
+    kFrameBattery = 1 << 3,
+};
+
+// Decoded, still-scaled contents of a frame.
+struct TelemetryFrame {
+    uint8_t valid = 0;
+    uint32_t seq = 0;
+    int32_t latitude_e7 = 0;
+    int32_t longitude_e7 = 0;
+    int16_t altitude_dm = 0;
+    int16_t heading_cdeg = 0;
+    uint8_t battery_percent = 0;
+};
+
+// Fixed-point scalings shared by the frame and the delta stream.
+int32_t scale_degrees_e7(double degrees);
+int16_t scale_altitude_dm(float metres);
+int16_t scale_heading_cdeg(double degrees);
+uint8_t scale_battery_percent(float percent);
+
+// Reads the store's latest samples into a frame tagged with `seq`.
+TelemetryFrame make_frame(TelemetryStore& store, uint64_t seq);
+
+FrameBytes encode_frame(const TelemetryFrame& frame);
+// Returns false if `size` or the version byte does not match.
+bool decode_frame(const uint8_t* data, size_t size, TelemetryFrame& frame);
+
+inline std::string frame_string(const FrameBytes& bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
@@ -0,0 +1,114 @@
+#include "telemetry_http.h"
+#include "telemetry_frame.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const std::string& etag_prefix() {
+    static const std::string prefix = [] {
+        char buf[24];
+        auto now = std::chrono::system_clock::now().time_since_epoch();
+        std::snprintf(buf, sizeof(buf), "\"%llx-",
+                      static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::seconds>(now).count()));
+        return std::string(buf);
+    }();
+    return prefix;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+}
+
+std::string telemetry_etag(uint64_t seq, const char* variant) {
+    return etag_prefix() + std::to_string(seq) + variant + "\"";
+}
+
+bool wants_binary(const httplib::Request& req) {
+    return req.get_header_value("Accept").find("application/octet-stream") != std::string::npos;
+}
+
+bool answer_not_modified(const httplib::Request& req, httplib::Response& res, const std::string& etag) {
+    auto header = req.get_header_value("If-None-Match");
+    if (header.empty()) {
+        return false;
+    }
+    // If-None-Match uses weak comparison: W/"x" matches "x".
+    bool matched = false;
+    size_t pos = 0;
+    while (pos < header.size() && !matched) {
+        size_t end = header.find(',', pos);
+        if (end == std::string::npos) {
+            end = header.size();
+        }
+        size_t begin = pos;
+        while (begin < end && is_space(header[begin])) {
+            ++begin;
+        }
+        size_t last = end;
+        while (last > begin && is_space(header[last - 1])) {
+            --last;
+        }
+        if (header.compare(begin, 2, "W/") == 0) {
+            begin += 2;
+        }
+        matched = header.compare(begin, last - begin, etag) == 0 || header.compare(begin, last - begin, "*") == 0;
+        pos = end + 1;
+    }
+    if (!matched) {
+        return false;
+    }
+    res.status = 304;
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");
+    return true;
+}
+
+void serve_state(const httplib::Request& req, httplib::Response& res, TelemetryStore& store) {
+    // Read the version first: if a sample lands in between, the body is newer
+    // than its tag and the next poll simply gets a fresh 200.
+    uint64_t version = store.version();
+    bool binary = wants_binary(req);
+    auto etag = telemetry_etag(version, binary ? "b" : "");
+    res.set_header("Vary", "Accept");
+    if (answer_not_modified(req, res, etag)) {
+        return;
+    }
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");
+    if (binary) {
+        res.set_content(frame_string(encode_frame(make_frame(store, version))), "application/octet-stream");
+    } else {
+        res.set_content(store.state_json(version), "application/json");
+    }
+}
+
+bool LongPollGate::wait(const httplib::Request& req, httplib::Response& res, TelemetryStore& store) {
+    if (!req.has_param("after")) {
+        return true;
+    }
+    uint64_t after = std::strtoull(req.get_param_value("after").c_str(), nullptr, 10);
+    if (store.version() > after) {
+        return true;
+    }
+    auto timeout = kDefaultTimeout;
+    if (req.has_param("timeout")) {
+        timeout = std::chrono::milliseconds(std::atoll(req.get_param_value("timeout").c_str()));
+        timeout = std::min(std::max(timeout, std::chrono::milliseconds(0)), kMaxTimeout);
+    }
+    if (active_.fetch_add(1, std::memory_order_acquire) >= slots_) {
+        active_.fetch_sub(1, std::memory_order_release);
+        res.status = 503;
+        res.set_header("Retry-After", "1");
+        res.set_content("Too many long-polls in progress.", "text/plain");
+        return false;
+    }
+    store.wait_for_version(after, timeout);
+    active_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "httplib.h"
+#include "telemetry_store.h"
+
+// Conditional GET for the telemetry routes. Each response carries an ETag
+// derived from the sample sequence number; a poll whose If-None-Match still
+// names the current sequence gets a bodyless 304 without the channel being
+// read or serialized.
+
+// Strong ETag for a sequence number. It embeds the process start time so
+// tags issued before a restart never match the new counters; `variant`
+// distinguishes other encodings of the same sequence.
+std::string telemetry_etag(uint64_t seq, const char* variant = "");
+
+// If If-None-Match lists `etag` (or "*"), turns `res` into a 304 carrying
+// that ETag and returns true.
+bool answer_not_modified(const httplib::Request& req, httplib::Response& res, const std::string& etag);
+
+template <typename T>
+void serve_sample(const httplib::Request& req, httplib::Response& res, TelemetryChannel<T>& channel) {
+    if (answer_not_modified(req, res, telemetry_etag(channel.seq()))) {
+        return;
+    }
+    auto sample = channel.read();
+    res.set_header("ETag", telemetry_etag(sample.seq));
+    res.set_header("Cache-Control", "no-cache");
+    res.set_content(sample_json(sample), "application/json");
+}
+
+// True if the client asked for the binary frame (Accept: application/octet-stream).
+bool wants_binary(const httplib::Request& req);
+
+// /state, tagged with the store's version; JSON, or the binary frame from
+// telemetry_frame.h if wants_binary().
+void serve_state(const httplib::Request& req, httplib::Response& res, TelemetryStore& store);
+
+// Long-poll for /state?after=<seq>&timeout=<ms>: holds the request until the
+// store's version exceeds `after`, so clients see changes within a callback
+// instead of a poll interval. Each waiter parks an httplib worker, so at most
+// `slots` may wait at once; the rest get 503 with Retry-After.
+class LongPollGate {
+public:
+    static constexpr std::chrono::milliseconds kDefaultTimeout{20000};
+    static constexpr std::chrono::milliseconds kMaxTimeout{30000};
+
+    explicit LongPollGate(size_t slots) : slots_(slots) {}
+
+    // Returns true once the request may be answered (immediately if it has no
+    // `after`, or it is already stale, or after the wait); false if `res` has
+    // been set to 503.
+    bool wait(const httplib::Request& req, httplib::Response& res, TelemetryStore& store);
+
+private:
+    size_t slots_;
+    std::atomic<size_t> active_{0};
+};
@@ -0,0 +1,140 @@
+#include "telemetry_store.h"
+
+#include <utility>
+#include "metrics.h"
+
+namespace {
+
+template <typename T>
+std::string channel_latency_json(const TelemetryChannel<T>& channel) {
+    return "\"" + channel.name() + "\": { \"serve_latency\": " + channel.serve_latency().snapshot().to_json() +
+           ", \"inter_arrival\": " + channel.inter_arrival().snapshot().to_json() +
+           ", \"jitter\": " + channel.jitter().snapshot().to_json() + " }";
+}
+
+template <typename T>
+void append_channel_prometheus(std::string& out, const TelemetryChannel<T>& channel) {
+    std::string labels = "channel=\"" + channel.name() + "\"";
+    out += "foam_telemetry_callbacks_total{" + labels + "} " + std::to_string(channel.received()) + "\n";
+    append_prometheus_histogram(out, "foam_telemetry_serve_age_seconds", labels, channel.serve_latency().snapshot());
+    append_prometheus_histogram(out, "foam_telemetry_inter_arrival_seconds", labels, channel.inter_arrival().snapshot());
+    append_prometheus_histogram(out, "foam_telemetry_jitter_seconds", labels, channel.jitter().snapshot());
+}
+
+template <typename T>
+void append_channel_state(std::string& json, bool selected, TelemetryChannel<T>& channel) {
+    if (selected) {
+        json += ", \"" + channel.name() + "\": " + sample_json(channel.read());
+    }
+}
+
+}
+
+std::string sample_json(const Sample<Position>& position) {
+    return "{ \"latitude\": " + std::to_string(position.value.latitude) +
+           ", \"longitude\": " + std::to_string(position.value.longitude) +
+           ", \"age_ms\": " + age_ms_json(position) + " }";
+}
+
+std::string sample_json(const Sample<MissionProgress>& progress) {
+    return "{ \"current\": " + std::to_string(progress.value.current) +
+           ", \"total\": " + std::to_string(progress.value.total) +
+           ", \"age_ms\": " + age_ms_json(progress) + " }";
+}
+
+std::string sample_json(const Sample<Battery>& battery) {
+    return "{ \"remaining_percent\": " + std::to_string(battery.value.remaining_percent) +
+           ", \"voltage_v\": " + std::to_string(battery.value.voltage_v) +
+           ", \"age_ms\": " + age_ms_json(battery) + " }";
+}
+
+std::string sample_json(const Sample<Altitude>& altitude) {
+    return "{ \"relative_altitude_m\": " + std::to_string(altitude.value.relative_altitude_m) +
+           ", \"sea_level_altitude_m\": " + std::to_string(altitude.value.sea_level_altitude_m) +
+           ", \"age_ms\": " + age_ms_json(altitude) + " }";
+}
+
+std::string sample_json(const Sample<Heading>& heading) {
+    return "{ \"heading_deg\": " + std::to_string(heading.value.heading_deg) +
+           ", \"age_ms\": " + age_ms_json(heading) + " }";
+}
+
+bool parse_state_fields(const std::string& list, unsigned& fields) {
+    static const std::pair<const char*, unsigned> names[] = {
+        {"position", kStatePosition}, {"mission_progress", kStateMissionProgress}, {"battery", kStateBattery},
+        {"altitude", kStateAltitude}, {"heading", kStateHeading},
+    };
+    fields = 0;
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string name = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (name.empty()) {
+            continue;
+        }
+        unsigned bit = 0;
+        for (const auto& entry : names) {
+            if (name == entry.first) {
+                bit = entry.second;
+            }
+        }
+        if (!bit) {
+            return false;
+        }
+        fields |= bit;
+    }
+    return true;
+}
+
+std::string TelemetryStore::state_json(uint64_t seq, unsigned fields) {
+    std::string json;
+    json.reserve(448);
+    json += "{ \"seq\": " + std::to_string(seq);
+    append_channel_state(json, fields & kStatePosition, position);
+    append_channel_state(json, fields & kStateMissionProgress, mission_progress);
+    append_channel_state(json, fields & kStateBattery, battery);
+    append_channel_state(json, fields & kStateAltitude, altitude);
+    append_channel_state(json, fields & kStateHeading, heading);
+    json += " }";
+    return json;
+}
+
+uint64_t TelemetryStore::wait_for_version(uint64_t after, SteadyClock::duration timeout) {
+    changes.waiters.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(changes.mutex);
+        changes.cond.wait_for(lock, timeout, [&] { return version() > after; });
+    }
+    changes.waiters.fetch_sub(1);
+    return version();
+}
+
+std::string TelemetryStore::latency_json() const {
+    return "{ " + channel_latency_json(position) +
+           ", " + channel_latency_json(mission_progress) +
+           ", " + channel_latency_json(battery) +
+           ", " + channel_latency_json(altitude) +
+           ", " + channel_latency_json(heading) + " }";
+}
+
+std::string TelemetryStore::prometheus() const {
+    std::string out;
+    out += "# HELP foam_telemetry_callbacks_total MAVSDK callbacks received per telemetry channel.\n";
+    out += "# TYPE foam_telemetry_callbacks_total counter\n";
+    out += "# HELP foam_telemetry_serve_age_seconds Sample age when served over HTTP.\n";
+    out += "# TYPE foam_telemetry_serve_age_seconds histogram\n";
+    out += "# HELP foam_telemetry_inter_arrival_seconds Time between consecutive callbacks.\n";
+    out += "# TYPE foam_telemetry_inter_arrival_seconds histogram\n";
+    out += "# HELP foam_telemetry_jitter_seconds Change in inter-arrival time between consecutive callbacks.\n";
+    out += "# TYPE foam_telemetry_jitter_seconds histogram\n";
+    append_channel_prometheus(out, position);
+    append_channel_prometheus(out, mission_progress);
+    append_channel_prometheus(out, battery);
+    append_channel_prometheus(out, altitude);
+    append_channel_prometheus(out, heading);
+    return out;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "latency_histogram.h"
+#include "sharded_metrics.h"
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct Position {
+    double latitude = 0.0;
+    double longitude = 0.0;
+};
+
+struct MissionProgress {
+    int current = 0;
+    int total = 0;
+};
+
+struct Battery {
+    float remaining_percent = 0.0f;
+    float voltage_v = 0.0f;
+};
+
+struct Altitude {
+    float relative_altitude_m = 0.0f;
+    float sea_level_altitude_m = 0.0f;
+};
+
+struct Heading {
+    double heading_deg = 0.0;
+};
+
+inline bool operator==(const Position& a, const Position& b) {
+    return a.latitude == b.latitude && a.longitude == b.longitude;
+}
+inline bool operator==(const MissionProgress& a, const MissionProgress& b) {
+    return a.current == b.current && a.total == b.total;
+}
+inline bool operator==(const Battery& a, const Battery& b) {
+    return a.remaining_percent == b.remaining_percent && a.voltage_v == b.voltage_v;
+}
+inline bool operator==(const Altitude& a, const Altitude& b) {
+    return a.relative_altitude_m == b.relative_altitude_m && a.sea_level_altitude_m == b.sea_level_altitude_m;
+}
+inline bool operator==(const Heading& a, const Heading& b) {
+    return a.heading_deg == b.heading_deg;
+}
+
+// A telemetry value plus the monotonic time its MAVSDK callback fired.
+template <typename T>
+struct Sample {
+    T value{};
+    SteadyClock::time_point received_at{};
+    // Advances each time the channel's value changes; 0 before the first
+    // sample. Repeated callbacks with an identical value keep the same seq.
+    uint64_t seq = 0;
+
+    bool valid() const { return received_at != SteadyClock::time_point{}; }
+};
+
+// Wakes threads waiting for any channel of a store to change. Publishers only
+// touch the mutex while someone is waiting, so callbacks stay lock-light.
+struct ChangeSignal {
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<size_t> waiters{0};
+
+    void notify() {
+        if (waiters.load() == 0) {
+            return;
+        }
+        { std::lock_guard<std::mutex> lock(mutex); }
+        cond.notify_all();
+    }
+};
+
+// Latest sample of one telemetry channel. publish() runs on the MAVSDK callback
+// thread, read() on HTTP workers; both also feed the channel's histograms.
+template <typename T>
+class TelemetryChannel {
+public:
+    explicit TelemetryChannel(std::string name, ChangeSignal* changes = nullptr)
+        : name_(std::move(name)), changes_(changes) {}
+
+    void publish(const T& value) {
+        auto now = SteadyClock::now();
+        bool changed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (sample_.valid()) {
+                auto interval = now - sample_.received_at;
+                inter_arrival_.record(interval);
+                if (last_interval_ != SteadyClock::duration::zero()) {
+                    jitter_.record(interval > last_interval_ ? interval - last_interval_ : last_interval_ - interval);
+                }
+                last_interval_ = interval;
+            }
+            changed = !sample_.valid() || !(sample_.value == value);
+            if (changed) {
+                sample_.seq = seq_.load(std::memory_order_relaxed) + 1;
+                // seq_cst, paired with ChangeSignal::waiters, so a waiter that
+                // finds no change cannot also be skipped by notify().
+                seq_.store(sample_.seq);
+            }
+            sample_.value = value;
+            sample_.received_at = now;
+            received_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (changed && changes_) {
+            changes_->notify();
+        }
+    }
+
+    Sample<T> read() {
+        Sample<T> sample;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sample = sample_;
+        }
+        if (sample.valid()) {
+            serve_latency_.record(SteadyClock::now() - sample.received_at);
+        }
+        return sample;
+    }
+
+    const std::string& name() const { return name_; }
+    uint64_t received() const { return received_.load(std::memory_order_relaxed); }
+    // Sequence number of the latest sample, readable without taking the lock.
+    uint64_t seq() const { return seq_.load(); }
+    const ShardedHistogram& serve_latency() const { return serve_latency_; }
+    const LatencyHistogram& inter_arrival() const { return inter_arrival_; }
+    const LatencyHistogram& jitter() const { return jitter_; }
+
+private:
+    std::string name_;
+    ChangeSignal* changes_;
+    std::mutex mutex_;
+    Sample<T> sample_;
+    SteadyClock::duration last_interval_ = SteadyClock::duration::zero();
+    std::atomic<uint64_t> received_{0};
+    std::atomic<uint64_t> seq_{0};
+    ShardedHistogram serve_latency_;
+    LatencyHistogram inter_arrival_;
+    LatencyHistogram jitter_;
+};
+
+// Channel bits for a projected TelemetryStore::state_json().
+enum StateField : unsigned {
+    kStatePosition = 1u << 0,
+    kStateMissionProgress = 1u << 1,
+    kStateBattery = 1u << 2,
+    kStateAltitude = 1u << 3,
+    kStateHeading = 1u << 4,
+    kStateAllFields = (1u << 5) - 1,
+};
+
+// Parses a comma-separated list of channel names ("position,battery") into
+// StateField bits. Returns false if a name is unknown.
+bool parse_state_fields(const std::string& list, unsigned& fields);
+
+struct TelemetryStore {
+    ChangeSignal changes;
+    TelemetryChannel<Position> position{"position", &changes};
+    TelemetryChannel<MissionProgress> mission_progress{"mission_progress", &changes};
+    TelemetryChannel<Battery> battery{"battery", &changes};
+    TelemetryChannel<Altitude> altitude{"altitude", &changes};
+    TelemetryChannel<Heading> heading{"heading", &changes};
+
+    // Every channel's latest sample in one object, as served by /state, with
+    // `seq` (normally version()) so clients can long-poll for the next one.
+    // `fields` limits it to those channels; unselected channels are not read.
+    std::string state_json(uint64_t seq, unsigned fields = kStateAllFields);
+    // Sum of the channel sequence numbers: grows whenever any channel's
+    // value changes, and is the ETag sequence for /state.
+    uint64_t version() const {
+        return position.seq() + mission_progress.seq() + battery.seq() + altitude.seq() + heading.seq();
+    }
+    // Blocks until version() exceeds `after` or `timeout` passes; returns
+    // the version at wake-up.
+    uint64_t wait_for_version(uint64_t after, SteadyClock::duration timeout);
+
+    // Per-channel callback-to-serve latency, inter-arrival and jitter histograms.
+    std::string latency_json() const;
+    // Callback counters and the same histograms in Prometheus text format.
+    std::string prometheus() const;
+};
+
+// Milliseconds since the sample arrived, or "null" if nothing arrived yet.
+template <typename T>
+std::string age_ms_json(const Sample<T>& sample) {
+    if (!sample.valid()) {
+        return "null";
+    }
+    return std::to_string(std::chrono::duration<double, std::milli>(SteadyClock::now() - sample.received_at).count());
+}
+
+// JSON bodies of the per-channel telemetry routes.
+std::string sample_json(const Sample<Position>& position);
+std::string sample_json(const Sample<MissionProgress>& progress);
+std::string sample_json(const Sample<Battery>& battery);
+std::string sample_json(const Sample<Altitude>& altitude);
+std::string sample_json(const Sample<Heading>& heading);
@@ -2,223 +2,656 @@
 #include <string>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <thread>
 #include <chrono>
 #include <future>
+#include <mutex>
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/telemetry/telemetry.h>
 #include <mavsdk/plugins/mission/mission.h>
 #include <mavsdk/plugins/action/action.h>
 #include "httplib.h"
 #include <memory>
-
-struct Position {
-    double latitude = 0.0;
-    double longitude = 0.0;
-};
-
-struct MissionProgress {
-    int current = 0;
-    int total = 0;
-};
-
-struct Battery {
-    float remaining_percent = 0.0f;
-    float voltage_v = 0.0f;
-};
-
-struct Altitude {
-    float relative_altitude_m = 0.0f;
-    float sea_level_altitude_m = 0.0f;
-};
-
-struct Heading {
-    double heading_deg = 0.0;
-};
-
-std::vector<mavsdk::Mission::MissionItem> read_waypoints(std::istream& stream) {
-    std::vector<mavsdk::Mission::MissionItem> items;
-    std::string line;
-    while (std::getline(stream, line)) {
-        std::stringstream ss(line);
-        std::string lat_str, lon_str, alt_str;
-        if (std::getline(ss, lat_str, ',') && std::getline(ss, lon_str, ',') && std::getline(ss, alt_str, ',')) {
-            try {
-                double lat = std::stod(lat_str);
-                double lon = std::stod(lon_str);
-                float alt = std::stof(alt_str);
-                mavsdk::Mission::MissionItem new_item{};
-                new_item.latitude_deg = lat;
-                new_item.longitude_deg = lon;
-                new_item.relative_altitude_m = alt;
-                new_item.is_fly_through = false;
-                items.push_back(new_item);
-            } catch (const std::exception& e) {
-                std::cerr << "Warning: Skipping invalid line '" << line << "': " << e.what() << std::endl;
-            }
-        }
-    }
-    return items;
-}
+#include "logger.h"
+#include "cors.h"
+#include "deconfliction.h"
+#include "delta_stream.h"
+#include "event_server.h"
+#include "fleet.h"
+#include "fleet_start.h"
+#include "flight_task_queue.h"
+#include "metrics.h"
+#include "mission_compiler.h"
+#include "response_compression.h"
+#include "server_config.h"
+#include "start_timing.h"
+#include "static_router.h"
+#include "telemetry_frame.h"
+#include "telemetry_http.h"
+#include "telemetry_store.h"
+#include "waypoint_parser.h"
 
 void wait_until_ready(std::shared_ptr<mavsdk::System> system) {
     auto telemetry = mavsdk::Telemetry{system};
     while (!telemetry.health_all_ok()) {
-        std::cout << "Vehicle not ready. Waiting..." << std::endl;
+        log_info("vehicle.not_ready");
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
-    std::cout << "Vehicle ready to arm." << std::endl;
+    log_info("vehicle.ready");
 }
 
 int main(int argc, char** argv) {
+    ServerConfig config;
+    std::string config_error;
+    if (!parse_server_config(argc, argv, config, config_error)) {
+        std::cerr << config_error << "\n" << server_config_usage();
+        return 1;
+    }
     mavsdk::Mavsdk mavsdk{mavsdk::Mavsdk::Configuration{mavsdk::ComponentType::GroundStation}};
-    std::cout << "Connecting to drone simulator..." << std::endl;
+    log_info("vehicle.connecting").field("url", "udpin://0.0.0.0:14550");
     auto result = mavsdk.add_any_connection("udpin://0.0.0.0:14550");
     if (result != mavsdk::ConnectionResult::Success) {
-        std::cerr << "connection failed: " << result << std::endl;
+        log_error("vehicle.connection_failed").field("result", result);
+        logger().flush();
         return 1;
     }
+    // Vehicles register as MAVSDK discovers them; the first one to connect
+    // also answers the unprefixed routes.
+    Fleet fleet{mavsdk, config.dispenser};
+    fleet.start();
     std::this_thread::sleep_for(std::chrono::seconds(5));
-    auto system = mavsdk.systems().empty() ? nullptr : mavsdk.systems().at(0);
-    if (!system) {
-        std::cout << "drone not found" << std::endl;
+    auto vehicles = fleet.vehicles();
+    if (vehicles->empty()) {
+        log_error("vehicle.not_found");
+        logger().flush();
         return 1;
     }
-    std::cout << "successfully connected to a drone" << std::endl;
-    wait_until_ready(system);
-    auto mission = mavsdk::Mission{system};
-    auto action = mavsdk::Action{system};
-    auto telemetry = mavsdk::Telemetry{system};
-    auto last_position = std::make_shared<Position>();
-    telemetry.subscribe_position([&](mavsdk::Telemetry::Position position) {
-        last_position->latitude = position.latitude_deg;
-        last_position->longitude = position.longitude_deg;
-    });
-    auto mission_progress = std::make_shared<MissionProgress>();
-    mission.subscribe_mission_progress([&](mavsdk::Mission::MissionProgress progress) {
-        mission_progress->current = progress.current;
-        mission_progress->total = progress.total;
-    });
-    auto battery_status = std::make_shared<Battery>();
-    telemetry.subscribe_battery([&](mavsdk::Telemetry::Battery battery) {
-        battery_status->remaining_percent = battery.remaining_percent;
-        battery_status->voltage_v = battery.voltage_v;
-    });
-    auto altitude = std::make_shared<Altitude>();
-    telemetry.subscribe_altitude([&](mavsdk::Telemetry::Altitude alt) {
-        altitude->relative_altitude_m = alt.altitude_relative_m;
-        altitude->sea_level_altitude_m = alt.altitude_amsl_m;
-    });
-    auto heading = std::make_shared<Heading>();
-    telemetry.subscribe_heading([&](mavsdk::Telemetry::Heading head) {
-        heading->heading_deg = head.heading_deg;
-    });
+    std::shared_ptr<Vehicle> primary = vehicles->front();
+    log_info("vehicle.connected").field("id", static_cast<int>(primary->id)).field("vehicles", vehicles->size());
+    wait_until_ready(primary->system);
+    Metrics metrics;
     httplib::Server svr;
-    svr.set_pre_routing_handler([](const httplib::Request&, httplib::Response& res) {
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type");
-        res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        return httplib::Server::HandlerResponse::Unhandled;
+    svr.new_task_queue = [&metrics, &config] {
+        return new InstrumentedTaskQueue(new FlightTaskQueue(config), metrics);
+    };
+    CorsPolicy cors{config.cors_origins};
+    svr.set_header_writer([&cors](httplib::Stream& strm, httplib::Headers& headers) {
+        return cors.write_headers(strm, headers);
     });
-    svr.Options("/(.*)", [](const httplib::Request&, httplib::Response& res) {
-        res.status = 204;
+    // Literal GET routes are dispatched from pre-routing by hash lookup; only
+    // /start (which has a body) and the parameterized /vehicles/{id} routes
+    // reach httplib's regex router.
+    StaticRouter router;
+    svr.set_pre_routing_handler([&metrics, &cors, &router](const httplib::Request& req, httplib::Response& res) {
+        if (is_shedding_load()) {
+            metrics.shed_requests().add(1);
+            res.status = 503;
+            res.set_header("Retry-After", "1");
+            res.set_header("Connection", "close");
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        if (cors.handle(req, res) == httplib::Server::HandlerResponse::Handled) {
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        return router.dispatch(req, res);
     });
-    svr.Get("/hello", [](const httplib::Request &, httplib::Response &res) {
+    router.Get("/hello", metrics.instrument("/hello", [](const httplib::Request &, httplib::Response &res) {
         res.set_content("Hello, World!", "text/plain");
-    });
+    }));
+
+    // Vehicle routes are written once against a Vehicle and mounted twice:
+    // under /vehicles/{id} for every vehicle, and unprefixed for `primary`.
+    auto on_primary = [primary](Fleet::Handler handler) -> httplib::Server::Handler {
+        return [primary, handler](const httplib::Request &req, httplib::Response &res) {
+            handler(*primary, req, res);
+        };
+    };
+    const std::string vehicle_pattern = R"(/vehicles/(\d+))";
+    const std::string vehicle_label = "/vehicles/{id}";
 
-    svr.Post("/start", [&](const httplib::Request &req, httplib::Response &res) {
-        std::cout << "Received /start request with waypoint data." << std::endl;
-        std::stringstream waypoint_stream(req.body);
-        auto mission_items = read_waypoints(waypoint_stream);
+    ControlLane control_lane{config.control_threads};
+    StartPhaseMetrics start_metrics;
+    ResponseCompressor compressor{config.compress_min_bytes, config.compression_cache_mb << 20};
+    // Parsed waypoints are all full stops; unless ?compile=0, they are
+    // compiled into a fly-through mission cruising at ?speed_m_s= (default 5).
+    auto compile_requested = [](const httplib::Request &req, MissionCompilerOptions &options) {
+        if (req.has_param("speed_m_s")) {
+            options.cruise_speed_m_s = std::atof(req.get_param_value("speed_m_s").c_str());
+        }
+        return req.get_param_value("compile") != "0";
+    };
+    Fleet::HandlerWithContentReader start_mission = [&](Vehicle &vehicle, const httplib::Request &req,
+                                                        httplib::Response &res, const httplib::ContentReader &reader) {
+        StartTimings timings;
+        size_t waypoint_count = 0;
+        std::string compiled = "null";
+        auto reply = [&](int status, const std::string& message) {
+            start_metrics.record(timings);
+            std::string json = "{ \"message\": \"" + message + "\", \"waypoints\": " + std::to_string(waypoint_count) +
+                               ", \"compiled\": " + compiled + ", \"timings\": " + timings.to_json() + " }";
+            res.status = status;
+            res.set_content(json, "application/json");
+        };
+        // Parse the body as it arrives instead of buffering it first.
+        WaypointParser parser;
+        reader([&](const char* data, size_t size) {
+            parser.feed(data, size);
+            return true;
+        });
+        parser.finish();
+        timings.finish(StartPhase::Parse);
+        log_info("start.received").field("vehicle", static_cast<int>(vehicle.id)).field("bytes", parser.bytes())
+            .field("invalid_lines", parser.invalid_lines());
+        auto& mission_items = parser.items();
+        waypoint_count = mission_items.size();
         if (mission_items.empty()) {
-            std::cerr << "Error: No valid waypoints found in request." << std::endl;
-            res.set_content("No valid waypoints found!", "text/plain");
-            res.status = 400;
+            log_error("start.no_waypoints");
+            reply(400, "No valid waypoints found!");
             return;
         }
-        std::cout << "Successfully parsed " << mission_items.size() << " waypoints." << std::endl;
+        log_info("start.parsed").field("waypoints", mission_items.size());
+        MissionCompilerOptions compile_options;
+        if (compile_requested(req, compile_options)) {
+            if (!(compile_options.cruise_speed_m_s > 0.0)) {
+                reply(400, "speed_m_s must be positive!");
+                return;
+            }
+            MissionCompileReport report = compile_mission(mission_items, compile_options);
+            timings.finish(StartPhase::Compile);
+            compiled = report.to_json();
+            log_info("start.compiled").field("fly_through", report.fly_through).field("stops", report.stops)
+                .field("saved_s", report.saved_s());
+        }
         mavsdk::Mission::MissionPlan mission_plan{};
-        mission_plan.mission_items = mission_items;
-        mavsdk::Mission::Result upload_result = mission.upload_mission(mission_plan);
+        mission_plan.mission_items = std::move(mission_items);
+        mavsdk::Mission::Result upload_result =
+            vehicle.upload(std::move(mission_plan), fleet.next_upload_id(), std::move(parser.flows()));
+        timings.finish(StartPhase::Upload);
         if (upload_result != mavsdk::Mission::Result::Success) {
-            std::cerr << "Mission upload failed: " << upload_result << std::endl;
-            res.set_content("Mission upload failed!", "text/plain");
+            log_error("start.upload_failed").field("result", upload_result);
+            reply(200, "Mission upload failed!");
             return;
         }
-        std::cout << "Mission uploaded. Arming..." << std::endl;
-        mavsdk::Action::Result arm_result = action.arm();
+        log_info("start.uploaded");
+        mavsdk::Action::Result arm_result = vehicle.action.arm();
+        timings.finish(StartPhase::Arm);
         if (arm_result != mavsdk::Action::Result::Success) {
-            std::cerr << "Arming failed: " << arm_result << std::endl;
-            res.set_content("Arming failed!", "text/plain");
+            log_error("start.arm_failed").field("result", arm_result);
+            reply(200, "Arming failed!");
             return;
         }
-        std::cout << "Armed. Starting mission..." << std::endl;
-        mavsdk::Mission::Result start_result = mission.start_mission();
+        log_info("start.armed");
+        mavsdk::Mission::Result start_result = vehicle.mission.start_mission();
+        timings.finish(StartPhase::Start);
         if (start_result != mavsdk::Mission::Result::Success) {
-            std::cerr << "Mission start failed: " << start_result << std::endl;
-            res.set_content("Mission start failed!", "text/plain");
+            log_error("start.start_failed").field("result", start_result);
+            reply(200, "Mission start failed!");
             return;
         }
-        res.set_content("Mission started successfully!", "text/plain");
-    });
-    svr.Get("/pause", [&](const httplib::Request &, httplib::Response &res) {
-        std::cout << "Received /pause request." << std::endl;
-        mavsdk::Mission::Result pause_result = mission.pause_mission();
-        if (pause_result != mavsdk::Mission::Result::Success) {
-            std::cerr << "Failed to pause mission: " << pause_result << std::endl;
-            res.set_content("Failed to pause mission!", "text/plain");
+        reply(200, "Mission started successfully!");
+    };
+    svr.Post("/start", metrics.instrument("/start", control_lane.wrap([&start_mission, primary](
+        const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &reader) {
+        start_mission(*primary, req, res, reader);
+    })));
+    svr.Post(vehicle_pattern + "/start",
+             metrics.instrument(vehicle_label + "/start", control_lane.wrap(fleet.route(start_mission))));
+    // One body with a `[<id>]` waypoint section per vehicle; see fleet_start.h.
+    FleetLauncher launcher{config.fleet_upload_threads};
+    svr.Post("/fleet/start", metrics.instrument("/fleet/start", control_lane.wrap([&](const httplib::Request &req,
+        httplib::Response &res, const httplib::ContentReader &reader) {
+        StartTimings timings;
+        std::vector<VehicleStart> starts;
+        auto reply = [&](int status, const std::string& message) {
+            res.status = status;
+            res.set_content(fleet_start_json(message, starts, timings), "application/json");
+        };
+        FleetMissionParser parser;
+        reader([&](const char* data, size_t size) {
+            parser.feed(data, size);
+            return true;
+        });
+        parser.finish();
+        timings.finish(StartPhase::Parse);
+        if (!parser.bad_header().empty()) {
+            reply(400, "Invalid vehicle header!");
             return;
         }
-        res.set_content("Mission paused.", "text/plain");
-    });
-    svr.Get("/abort", [&](const httplib::Request &, httplib::Response &res) {
-        std::cout << "Received /abort request." << std::endl;
-        mavsdk::Mission::Result clear_result = mission.clear_mission();
-        if (clear_result != mavsdk::Mission::Result::Success) {
-             std::cerr << "Failed to clear mission: " << clear_result << std::endl;
-             res.set_content("Failed to abort mission!", "text/plain");
-             return;
-        }
-        std::cout << "Mission aborted and cleared." << std::endl;
-        res.set_content("Mission aborted.", "text/plain");
-    });
-    svr.Get("/resume", [&](const httplib::Request &, httplib::Response &res) {
-        std::cout << "Received /resume request." << std::endl;
-        mavsdk::Mission::Result resume_result = mission.start_mission();
-        if (resume_result != mavsdk::Mission::Result::Success) {
-            std::cerr << "Failed to resume mission: " << resume_result << std::endl;
-            res.set_content("Failed to resume mission!", "text/plain");
+        MissionCompilerOptions compile_options;
+        bool compile = compile_requested(req, compile_options);
+        if (compile && !(compile_options.cruise_speed_m_s > 0.0)) {
+            reply(400, "speed_m_s must be positive!");
             return;
         }
-        res.set_content("Mission resumed.", "text/plain");
-    });
-    svr.Get("/telemetry", [&](const httplib::Request &, httplib::Response &res) {
-        std::string json = "{ \"latitude\": " + std::to_string(last_position->latitude) +
-                           ", \"longitude\": " + std::to_string(last_position->longitude) + " }";
-        res.set_content(json, "application/json");
-    });
-    svr.Get("/mission_progress", [&](const httplib::Request &, httplib::Response &res) {
-        std::string json = "{ \"current\": " + std::to_string(mission_progress->current) +
-                           ", \"total\": " + std::to_string(mission_progress->total) + " }";
-        res.set_content(json, "application/json");
-    });
-    svr.Get("/battery", [&](const httplib::Request &, httplib::Response &res) {
-        std::string json = "{ \"remaining_percent\": " + std::to_string(battery_status->remaining_percent) +
-                           ", \"voltage_v\": " + std::to_string(battery_status->voltage_v) + " }";
-        res.set_content(json, "application/json");
+        for (auto& section : parser.sections()) {
+            VehicleStart start;
+            start.vehicle = fleet.find(section.first);
+            if (!start.vehicle) {
+                log_error("fleet_start.unknown_vehicle").field("vehicle", static_cast<int>(section.first));
+                reply(404, "Unknown vehicle " + std::to_string(section.first) + "!");
+                return;
+            }
+            start.plan.mission_items = std::move(section.second->items());
+            start.waypoints = start.plan.mission_items.size();
+            start.flows = std::move(section.second->flows());
+            if (start.plan.mission_items.empty()) {
+                log_error("fleet_start.no_waypoints").field("vehicle", static_cast<int>(section.first));
+                reply(400, "No valid waypoints for vehicle " + std::to_string(section.first) + "!");
+                return;
+            }
+            if (compile) {
+                MissionCompileReport report = compile_mission(start.plan.mission_items, compile_options);
+                log_info("fleet_start.compiled").field("vehicle", static_cast<int>(section.first))
+                    .field("fly_through", report.fly_through).field("saved_s", report.saved_s());
+            }
+            starts.push_back(std::move(start));
+        }
+        if (starts.empty()) {
+            reply(400, "No vehicles in request!");
+            return;
+        }
+        // Missions compile back to back, so each vehicle reports the batch's
+        // compile time.
+        if (compile) {
+            timings.finish(StartPhase::Compile);
+        }
+        for (auto& start : starts) {
+            start.timings = timings;
+        }
+        log_info("fleet_start.parsed").field("vehicles", starts.size()).field("bytes", parser.bytes());
+        std::string message;
+        bool started = launcher.launch(fleet, starts, timings, message);
+        reply(started ? 200 : 502, message);
+    })));
+    // Checks a /fleet/start body for legs of different vehicles that come
+    // within ?separation_m= (default 5) at the same time, assuming every
+    // vehicle flies at ?speed_m_s= (default 5) unless an item sets a speed.
+    // Missions are compiled as /fleet/start would, so leg speeds match.
+    svr.Post("/fleet/deconflict", metrics.instrument("/fleet/deconflict", control_lane.wrap([&](
+        const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &reader) {
+        FleetMissionParser parser;
+        reader([&](const char* data, size_t size) {
+            parser.feed(data, size);
+            return true;
+        });
+        parser.finish();
+        double separation_m = req.has_param("separation_m") ? std::atof(req.get_param_value("separation_m").c_str()) : 5.0;
+        double speed_m_s = req.has_param("speed_m_s") ? std::atof(req.get_param_value("speed_m_s").c_str()) : 5.0;
+        auto sections = parser.sections();
+        if (!parser.bad_header().empty() || sections.empty() || !(separation_m > 0.0) || !(speed_m_s > 0.0)) {
+            res.status = 400;
+            res.set_content("{ \"message\": \"Invalid deconfliction request!\" }", "application/json");
+            return;
+        }
+        auto started_at = std::chrono::steady_clock::now();
+        GeoOrigin origin;
+        std::vector<PathSegment> segments;
+        MissionCompilerOptions compile_options;
+        compile_options.cruise_speed_m_s = speed_m_s;
+        bool compile = compile_requested(req, compile_options);
+        for (auto& section : sections) {
+            auto& items = section.second->items();
+            if (compile) {
+                compile_mission(items, compile_options);
+            }
+            if (segments.empty() && !items.empty()) {
+                origin = {items[0].latitude_deg, items[0].longitude_deg};
+            }
+            auto legs = mission_segments(section.first, items, origin, speed_m_s);
+            segments.insert(segments.end(), legs.begin(), legs.end());
+        }
+        hold_at_mission_end(segments);
+        auto conflicts = find_conflicts(segments, separation_m);
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started_at).count();
+        log_info("fleet_deconflict.checked").field("segments", segments.size()).field("conflicts", conflicts.size())
+            .field("elapsed_ms", elapsed_ms);
+        compressor.set_content(req, res,
+                               "{ \"segments\": " + std::to_string(segments.size()) +
+                                   ", \"elapsed_ms\": " + std::to_string(elapsed_ms) +
+                                   ", \"conflicts\": " + conflicts_json(conflicts) + " }",
+                               "application/json");
+    })));
+    // Offboard mode flies through the body's waypoints at up to ?speed_m_s=
+    // (default 5), on a jerk-limited speed profile, by streaming setpoints
+    // at ?rate_hz= (20-50, default 50) instead of uploading a mission. A flow
+    // column drives the dispenser leg by leg, as in mission mode.
+    Fleet::HandlerWithContentReader offboard_start = [](Vehicle &vehicle, const httplib::Request &req,
+                                                        httplib::Response &res, const httplib::ContentReader &reader) {
+        WaypointParser parser;
+        reader([&](const char* data, size_t size) {
+            parser.feed(data, size);
+            return true;
+        });
+        parser.finish();
+        double rate_hz = req.has_param("rate_hz") ? std::atof(req.get_param_value("rate_hz").c_str()) : 50.0;
+        double speed_m_s = req.has_param("speed_m_s") ? std::atof(req.get_param_value("speed_m_s").c_str()) : 5.0;
+        double duration_s = 0.0;
+        auto reply = [&](int status, const std::string& message) {
+            res.status = status;
+            res.set_content("{ \"message\": \"" + message + "\", \"waypoints\": " +
+                                std::to_string(parser.items().size()) + ", \"duration_s\": " +
+                                std::to_string(duration_s) + " }",
+                            "application/json");
+        };
+        if (parser.items().empty()) {
+            log_error("offboard.no_waypoints");
+            reply(400, "No valid waypoints found!");
+            return;
+        }
+        if (!(rate_hz >= 20.0 && rate_hz <= 50.0) || !(speed_m_s > 0.0)) {
+            reply(400, "rate_hz must be 20-50 and speed_m_s positive!");
+            return;
+        }
+        auto here = vehicle.telemetry.position();
+        auto here_ned = vehicle.telemetry.position_velocity_ned().position;
+        VelocityLimits limits;
+        limits.max_speed_m_s = speed_m_s;
+        // The path starts where the vehicle is, so flows()[i], the flow on
+        // the leg ending at item i, is the flow on the path's leg i.
+        auto path = mission_path_ned(parser.items(), {here.latitude_deg, here.longitude_deg}, here.relative_altitude_m,
+                                     {here_ned.north_m, here_ned.east_m, here_ned.down_m});
+        auto trajectory =
+            std::make_shared<OffboardTrajectory>(plan_velocity_profile(path, limits), path, parser.flows());
+        duration_s = trajectory->duration_s();
+        log_info("offboard.received").field("vehicle", static_cast<int>(vehicle.id))
+            .field("waypoints", parser.items().size()).field("duration_s", duration_s).field("rate_hz", rate_hz);
+        mavsdk::Action::Result arm_result = vehicle.action.arm();
+        if (arm_result != mavsdk::Action::Result::Success) {
+            log_error("offboard.arm_failed").field("result", arm_result);
+            reply(200, "Arming failed!");
+            return;
+        }
+        mavsdk::Offboard::Result start_result =
+            vehicle.offboard_stream.start(trajectory, rate_hz, vehicle.store.heading.read().value.heading_deg);
+        if (start_result != mavsdk::Offboard::Result::Success) {
+            log_error("offboard.start_failed").field("result", start_result);
+            reply(200, "Offboard start failed!");
+            return;
+        }
+        reply(200, "Offboard streaming started!");
+    };
+    svr.Post("/offboard/start", metrics.instrument("/offboard/start", control_lane.wrap([&offboard_start, primary](
+        const httplib::Request &req, httplib::Response &res, const httplib::ContentReader &reader) {
+        offboard_start(*primary, req, res, reader);
+    })));
+    svr.Post(vehicle_pattern + "/offboard/start",
+             metrics.instrument(vehicle_label + "/offboard/start", control_lane.wrap(fleet.route(offboard_start))));
+    // Safety commands bypass the control lane: /abort must get a worker even
+    // while long uploads fill the lane.
+    std::vector<std::pair<std::string, Fleet::Handler>> safety_routes = {
+        {"/pause", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            log_info("pause.received");
+            if (vehicle.offboard_stream.active()) {
+                // An offboard print has no mission to pause: end the stream,
+                // which leaves offboard mode and holds position.
+                mavsdk::Offboard::Result stop_result = vehicle.offboard_stream.stop();
+                if (stop_result != mavsdk::Offboard::Result::Success) {
+                    log_error("pause.offboard_stop_failed").field("result", stop_result);
+                    res.set_content("Failed to pause offboard stream!", "text/plain");
+                    return;
+                }
+                res.set_content("Offboard stream stopped, holding position.", "text/plain");
+                return;
+            }
+            mavsdk::Mission::Result pause_result = vehicle.mission.pause_mission();
+            if (pause_result != mavsdk::Mission::Result::Success) {
+                log_error("pause.failed").field("result", pause_result);
+                res.set_content("Failed to pause mission!", "text/plain");
+                return;
+            }
+            res.set_content("Mission paused.", "text/plain");
+        }},
+        {"/abort", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            log_info("abort.received");
+            if (vehicle.offboard_stream.active()) {
+                mavsdk::Offboard::Result stop_result = vehicle.offboard_stream.stop();
+                if (stop_result != mavsdk::Offboard::Result::Success) {
+                    log_error("abort.offboard_stop_failed").field("result", stop_result);
+                    res.set_content("Failed to abort offboard stream!", "text/plain");
+                    return;
+                }
+                log_info("abort.offboard_stopped");
+            }
+            mavsdk::Mission::Result clear_result = vehicle.mission.clear_mission();
+            if (clear_result != mavsdk::Mission::Result::Success) {
+                 log_error("abort.failed").field("result", clear_result);
+                 res.set_content("Failed to abort mission!", "text/plain");
+                 return;
+            }
+            log_info("abort.cleared");
+            res.set_content("Mission aborted.", "text/plain");
+        }},
+        {"/dispenser/flow", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            double scale = req.has_param("scale") ? std::atof(req.get_param_value("scale").c_str()) : 1.0;
+            if (!(scale >= 0.0 && scale <= 2.0)) {
+                res.status = 400;
+                res.set_content("scale must be 0-2!", "text/plain");
+                return;
+            }
+            log_info("dispenser.flow").field("vehicle", static_cast<int>(vehicle.id)).field("scale", scale);
+            vehicle.dispenser.set_flow(scale);
+            res.set_content(scale > 0.0 ? "Dispensing." : "Dispenser off.", "text/plain");
+        }},
+        {"/offboard/stop", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            log_info("offboard.stop_received");
+            mavsdk::Offboard::Result stop_result = vehicle.offboard_stream.stop();
+            if (stop_result != mavsdk::Offboard::Result::Success) {
+                log_error("offboard.stop_failed").field("result", stop_result);
+                res.set_content("Failed to stop offboard mode!", "text/plain");
+                return;
+            }
+            res.set_content("Offboard stopped.", "text/plain");
+        }},
+    };
+    // The main pool is shared with keep-alive connections, each holding a
+    // worker between requests, so it cannot promise /abort a free worker.
+    // Safety commands are therefore also served by a listener of their own,
+    // with its own threads and one request per connection.
+    httplib::Server safety_svr;
+    safety_svr.new_task_queue = [&config] { return new httplib::ThreadPool(config.safety_threads); };
+    // A connection that never sends a request holds a thread until the
+    // keep-alive timeout, so keep that short too.
+    safety_svr.set_keep_alive_max_count(1);
+    safety_svr.set_keep_alive_timeout(1);
+    safety_svr.set_read_timeout(1, 0);
+    safety_svr.set_header_writer([&cors](httplib::Stream& strm, httplib::Headers& headers) {
+        return cors.write_headers(strm, headers);
     });
-    svr.Get("/altitude", [&](const httplib::Request &, httplib::Response &res) {
-        std::string json = "{ \"relative_altitude_m\": " + std::to_string(altitude->relative_altitude_m) +
-                           ", \"sea_level_altitude_m\": " + std::to_string(altitude->sea_level_altitude_m) + " }";
-        res.set_content(json, "application/json");
+    safety_svr.set_pre_routing_handler([&cors](const httplib::Request& req, httplib::Response& res) {
+        return cors.handle(req, res);
     });
-    svr.Get("/heading", [&](const httplib::Request &, httplib::Response &res) {
-        std::string json = "{ \"heading_deg\": " + std::to_string(heading->heading_deg) + " }";
+    for (const auto& route : safety_routes) {
+        auto primary_handler = metrics.instrument(route.first, on_primary(route.second));
+        auto vehicle_handler = metrics.instrument(vehicle_label + route.first, fleet.route(route.second));
+        router.Get(route.first, primary_handler);
+        svr.Get(vehicle_pattern + route.first, vehicle_handler);
+        safety_svr.Get(route.first, primary_handler);
+        safety_svr.Get(vehicle_pattern + route.first, vehicle_handler);
+    }
+    std::vector<std::pair<std::string, Fleet::Handler>> control_routes = {
+        {"/resume", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            log_info("resume.received");
+            mavsdk::Mission::Result resume_result = vehicle.mission.start_mission();
+            if (resume_result != mavsdk::Mission::Result::Success) {
+                log_error("resume.failed").field("result", resume_result);
+                res.set_content("Failed to resume mission!", "text/plain");
+                return;
+            }
+            res.set_content("Mission resumed.", "text/plain");
+        }},
+    };
+    for (const auto& route : control_routes) {
+        router.Get(route.first, metrics.instrument(route.first, control_lane.wrap(on_primary(route.second))));
+        svr.Get(vehicle_pattern + route.first, metrics.instrument(vehicle_label + route.first,
+                                                                  control_lane.wrap(fleet.route(route.second))));
+    }
+    std::vector<std::pair<std::string, Fleet::Handler>> telemetry_routes = {
+        {"/telemetry", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            serve_sample(req, res, vehicle.store.position);
+        }},
+        {"/mission_progress", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            serve_sample(req, res, vehicle.store.mission_progress);
+        }},
+        {"/battery", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            serve_sample(req, res, vehicle.store.battery);
+        }},
+        {"/altitude", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            serve_sample(req, res, vehicle.store.altitude);
+        }},
+        {"/heading", [](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            serve_sample(req, res, vehicle.store.heading);
+        }},
+        {"/offboard/status", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            res.set_content(vehicle.offboard_stream.status_json(), "application/json");
+        }},
+        {"/dispenser/status", [](Vehicle &vehicle, const httplib::Request &, httplib::Response &res) {
+            res.set_content(vehicle.dispenser.status_json(), "application/json");
+        }},
+        {"/telemetry/latency", [&](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+            compressor.set_content(req, res, vehicle.store.latency_json(), "application/json");
+        }},
+    };
+    std::vector<std::pair<std::string, httplib::Server::Handler>> primary_telemetry_routes;
+    for (const auto& route : telemetry_routes) {
+        primary_telemetry_routes.emplace_back(route.first, metrics.instrument(route.first, on_primary(route.second)));
+        router.Get(route.first, primary_telemetry_routes.back().second);
+        svr.Get(vehicle_pattern + route.first, metrics.instrument(vehicle_label + route.first, fleet.route(route.second)));
+    }
+    // /state?after=<seq> long-polls on the httplib port only; the event loop
+    // must never block, so its /state always answers immediately.
+    LongPollGate long_poll{config.long_poll_slots};
+    Fleet::Handler state = [&long_poll](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+        if (long_poll.wait(req, res, vehicle.store)) {
+            serve_state(req, res, vehicle.store);
+        }
+    };
+    router.Get("/state", metrics.instrument("/state", on_primary(state)));
+    svr.Get(vehicle_pattern + "/state", metrics.instrument(vehicle_label + "/state", fleet.route(state)));
+    Fleet::Handler uploaded_plan = [&compressor](Vehicle &vehicle, const httplib::Request &req, httplib::Response &res) {
+        auto plan = vehicle.uploaded_mission();
+        if (!plan) {
+            res.status = 404;
+            res.set_content("{ \"message\": \"No mission uploaded.\" }", "application/json");
+            return;
+        }
+        auto encoding = compressor.choose(req, plan->json().size());
+        auto etag = telemetry_etag(plan->id, (std::string("m-") + content_encoding_name(encoding)).c_str());
+        if (answer_not_modified(req, res, etag)) {
+            res.set_header("Vary", "Accept-Encoding");
+            return;
+        }
+        res.set_header("ETag", etag);
+        compressor.set_content(res, plan->json(), "application/json", encoding, "mission:" + std::to_string(plan->id));
+    };
+    router.Get("/mission", metrics.instrument("/mission", on_primary(uploaded_plan)));
+    svr.Get(vehicle_pattern + "/mission", metrics.instrument(vehicle_label + "/mission", fleet.route(uploaded_plan)));
+    router.Get("/vehicles", metrics.instrument("/vehicles", [&fleet](const httplib::Request &, httplib::Response &res) {
+        auto vehicles = fleet.vehicles();
+        std::string json = "{ \"vehicles\": [";
+        for (size_t i = 0; i < vehicles->size(); ++i) {
+            const auto& vehicle = (*vehicles)[i];
+            json += i ? ", " : " ";
+            json += "{ \"id\": " + std::to_string(vehicle->id) +
+                    ", \"connected\": " + (vehicle->system->is_connected() ? "true" : "false") + " }";
+        }
+        json += " ] }";
         res.set_content(json, "application/json");
+    }));
+    // One body for the whole fleet; ?fields=position,battery limits it to
+    // those channels.
+    router.Get("/fleet/state", metrics.instrument("/fleet/state", [&](const httplib::Request &req, httplib::Response &res) {
+        unsigned fields = kStateAllFields;
+        if (req.has_param("fields") && !parse_state_fields(req.get_param_value("fields"), fields)) {
+            res.status = 400;
+            res.set_content("{ \"message\": \"Unknown field.\" }", "application/json");
+            return;
+        }
+        res.set_header("Cache-Control", "no-cache");
+        compressor.set_content(req, res, fleet_state_json(*fleet.vehicles(), fields), "application/json");
+    }));
+    router.Get("/metrics", [&](const httplib::Request &req, httplib::Response &res) {
+        compressor.set_content(req, res,
+                               metrics.render_prometheus() + primary->store.prometheus() + start_metrics.prometheus() +
+                                   compressor.prometheus() + fleet_offboard_prometheus(*fleet.vehicles()) +
+                                   fleet_dispenser_prometheus(*fleet.vehicles()),
+                               "text/plain; version=0.0.4");
     });
-    std::cout << "Starting REST API server on port 8080..." << std::endl;
-    svr.listen("0.0.0.0", 8080);
+    // Telemetry routes are also served by an epoll event loop on a second
+    // port, together with /stream, so that many idle keep-alive and streaming
+    // clients do not each park an httplib worker. It serves `primary` only.
+    TelemetryStore& store = primary->store;
+    EventLoopServer stream_svr{config.stream_threads};
+    if (config.stream_port > 0) {
+        stream_svr.set_pre_routing_handler([&cors](const httplib::Request& req, httplib::Response& res) {
+            return cors.handle(req, res);
+        });
+        stream_svr.set_static_headers(cors.static_headers());
+        for (const auto& route : primary_telemetry_routes) {
+            stream_svr.Get(route.first, route.second);
+        }
+        stream_svr.Get("/state", metrics.instrument("/state", [&](const httplib::Request &req, httplib::Response &res) {
+            serve_state(req, res, store);
+        }));
+        stream_svr.Stream("/stream", [&](const httplib::Request &req, httplib::Response &res) {
+            if (req.get_param_value("encoding") == "delta") {
+                uint32_t keyframe = 50;
+                if (req.has_param("keyframe")) {
+                    keyframe = static_cast<uint32_t>(std::max(1LL, std::atoll(req.get_param_value("keyframe").c_str())));
+                }
+                res.set_header("Content-Type", "application/octet-stream");
+                return EventLoopServer::StreamProducer([&store, encoder = DeltaEncoder(keyframe)]() mutable {
+                    return encoder.next(store);
+                });
+            }
+            if (wants_binary(req)) {
+                // Back-to-back fixed-size frames; kFrameSize delimits them.
+                res.set_header("Content-Type", "application/octet-stream");
+                return EventLoopServer::StreamProducer([&store, last_version = uint64_t{0}]() mutable {
+                    uint64_t version = store.version();
+                    if (version == last_version) {
+                        return std::string();
+                    }
+                    last_version = version;
+                    return frame_string(encode_frame(make_frame(store, version)));
+                });
+            }
+            res.set_header("Content-Type", "text/event-stream");
+            return EventLoopServer::StreamProducer([&store, last_version = uint64_t{0}]() mutable {
+                uint64_t version = store.version();
+                if (version == last_version) {
+                    return std::string();
+                }
+                last_version = version;
+                return "data: " + store.state_json(version) + "\n\n";
+            });
+        }, std::chrono::milliseconds(100));
+        if (!stream_svr.listen(config.host, config.stream_port)) {
+            log_error("server.stream_listen_failed").field("port", config.stream_port);
+        } else {
+            log_info("server.stream_listening").field("port", config.stream_port).field("threads", config.stream_threads);
+        }
+    }
+    log_info("server.starting").field("host", config.host).field("port", config.port)
+        .field("telemetry_threads", config.telemetry_threads).field("control_threads", config.control_threads)
+        .field("max_queued", config.max_queued_connections);
+    std::thread safety_thread;
+    if (config.safety_port > 0) {
+        if (!safety_svr.bind_to_port(config.host, config.safety_port)) {
+            log_error("server.safety_listen_failed").field("port", config.safety_port);
+        } else {
+            log_info("server.safety_listening").field("port", config.safety_port)
+                .field("threads", config.safety_threads);
+            safety_thread = std::thread([&safety_svr] { safety_svr.listen_after_bind(); });
+        }
+    }
+    router.build();
+    // Idle keep-alive connections release their worker after keep_alive_s
+    // rather than httplib's 5 s, so pollers hold workers for less time.
+    svr.set_keep_alive_timeout(static_cast<time_t>(config.keep_alive_s));
+    svr.listen(config.host, config.port);
+    if (safety_thread.joinable()) {
+        safety_svr.stop();
+        safety_thread.join();
+    }
     return 0;
 }
\ No newline at end of file
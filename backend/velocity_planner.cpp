@@ -0,0 +1,306 @@
+#include "velocity_planner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double distance(const NedPoint& a, const NedPoint& b) {
+    double n = b.north_m - a.north_m;
+    double e = b.east_m - a.east_m;
+    double d = b.down_m - a.down_m;
+    return std::sqrt(n * n + e * e + d * d);
+}
+
+// Speed at which a vertex can be flown through, rounding the corner where
+// it starts `blend_m` before the vertex: the arc tangent to both legs there
+// has radius blend / tan(turn / 2).
+double corner_speed(const NedPoint& a, const NedPoint& b, const NedPoint& c, double in_m, double out_m,
+                    const VelocityLimits& limits) {
+    double cos_turn = ((b.north_m - a.north_m) * (c.north_m - b.north_m) + (b.east_m - a.east_m) * (c.east_m - b.east_m) +
+                       (b.down_m - a.down_m) * (c.down_m - b.down_m)) /
+                      (in_m * out_m);
+    if (cos_turn >= 1.0 - 1e-12) {
+        return limits.max_speed_m_s;
+    }
+    if (cos_turn <= -1.0) {
+        return 0.0;
+    }
+    // tan(turn / 2) from the cosine, saving an acos and a tan per point.
+    double blend = std::min(limits.corner_radius_m, 0.5 * std::min(in_m, out_m));
+    double radius = blend * std::sqrt((1.0 + cos_turn) / (1.0 - cos_turn));
+    return std::min(limits.max_speed_m_s, std::sqrt(limits.max_lateral_accel_m_s2 * std::max(radius, 0.0)));
+}
+
+// Time to cover `length` starting at `speed`, used to step the jerk limit.
+// From rest with zero acceleration that is the cube root of 6 d / j.
+double step_time(double length, double speed, double jerk) {
+    return speed > 0.0 ? length / speed : std::cbrt(6.0 * length / jerk);
+}
+
+// Largest acceleration over a step of `dt` from which the acceleration can
+// still ramp down to zero, at the jerk limit, within a remaining speed `gap`.
+// Evaluated mid-step, so the last step before the gap closes stays small.
+double ease(double jerk, double gap, double dt) {
+    return std::max(0.0, std::sqrt(2.0 * jerk * std::max(0.0, gap)) - jerk * dt / 2.0);
+}
+
+// Distance to go from one speed to another at the acceleration and jerk
+// limits, starting and ending with zero acceleration. The acceleration
+// profile is symmetric, so that is the mean speed times the ramp time.
+double ramp_distance(double from, double to, double max_accel, double jerk) {
+    double change = std::fabs(to - from);
+    double time = change * jerk <= max_accel * max_accel ? 2.0 * std::sqrt(change / jerk)
+                                                         : change / max_accel + max_accel / jerk;
+    return (from + to) / 2.0 * time;
+}
+
+// Fastest speed at each point when starting from rest at one end of the
+// path: the acceleration builds up at the jerk limit and eases off again
+// before the speed meets a cap, and drops to zero at a cap it is clamped
+// to. Run from the far end, it is the fastest each point can be and still
+// brake for what follows. Accelerations are means over a step, so from
+// one step to the next they change by the jerk times the time between the
+// two steps' midpoints, and by half a step's worth after a stop or a cap.
+std::vector<double> envelope(const std::vector<double>& caps, const std::vector<double>& steps,
+                             const VelocityLimits& limits, bool from_end) {
+    size_t m = caps.size();
+    double max_accel = limits.max_accel_m_s2;
+    double jerk = limits.max_jerk_m_s3;
+    std::vector<double> speeds(m);
+    speeds[from_end ? m - 1 : 0] = 0.0;
+    double accel = 0.0;
+    double last_dt = 0.0;
+    for (size_t k = 1; k < m; ++k) {
+        size_t i = from_end ? m - 1 - k : k;
+        double v = speeds[from_end ? i + 1 : i - 1];
+        double d = steps[from_end ? i : i - 1];
+        // The step takes less time than at its starting speed; one more
+        // round with the speed it reaches keeps the jerk under the limit.
+        double dt = step_time(d, v, jerk);
+        double limit = 0.0;
+        double speed = v;
+        for (int round = 0; round < 2; ++round) {
+            limit = std::min({max_accel, accel + jerk * (last_dt + dt) / 2.0, ease(jerk, caps[i] - v, dt)});
+            speed = std::sqrt(v * v + 2.0 * std::max(limit, 0.0) * d);
+            dt = 2.0 * d / (v + speed);
+        }
+        if (speed >= caps[i]) {
+            speeds[i] = caps[i];
+            accel = 0.0;
+            last_dt = 0.0;
+        } else {
+            speeds[i] = speed;
+            accel = limit;
+            last_dt = dt;
+        }
+    }
+    return speeds;
+}
+
+// Rounds of lowering caps and planning again before the profile is taken
+// as it is.
+constexpr int kLevelRounds = 4;
+
+// Where the speed-up from one valley runs into the braking for the next,
+// or into a cap it is clamped to, the acceleration can flip faster than the
+// jerk limit allows. Lowers the caps between the two valleys to the highest
+// speed both ramps can reach, easing in and out, within that stretch, so
+// the profile levels off there instead. Returns whether any cap was lowered.
+bool level_peaks(const std::vector<double>& rising, const std::vector<double>& braking, const std::vector<double>& steps,
+                 const VelocityLimits& limits, std::vector<double>& caps) {
+    size_t m = caps.size();
+    double max_accel = limits.max_accel_m_s2;
+    double jerk = limits.max_jerk_m_s3;
+    auto speed = [&](size_t i) { return std::min(rising[i], braking[i]); };
+    // Whether the acceleration changes too fast from step i to i + 1.
+    auto sharp = [&](size_t i) {
+        double v0 = speed(i), v1 = speed(i + 1), v2 = speed(i + 2);
+        if (v0 + v1 <= 0.0 || v1 + v2 <= 0.0) {
+            return false;
+        }
+        double dt0 = 2.0 * steps[i] / (v0 + v1);
+        double dt1 = 2.0 * steps[i + 1] / (v1 + v2);
+        return std::fabs((v2 - v1) / dt1 - (v1 - v0) / dt0) > jerk * (dt0 + dt1) / 2.0;
+    };
+    bool lowered = false;
+    for (size_t peak = 0; peak + 1 < m; ++peak) {
+        bool switches = braking[peak + 1] < rising[peak + 1] ||
+                        (braking[peak + 1] == rising[peak + 1] && rising[peak + 1] > rising[peak]);
+        if (!(rising[peak] <= braking[peak] && switches)) {
+            continue;
+        }
+        double high = std::max(rising[peak], braking[peak + 1]);
+        bool kink = (peak > 0 && sharp(peak - 1)) || (peak + 2 < m && sharp(peak));
+        size_t left = peak;
+        double length = 0.0;
+        while (left > 0 && rising[left - 1] <= braking[left - 1] && rising[left - 1] < rising[left]) {
+            length += steps[--left];
+        }
+        size_t right = peak + 1;
+        length += steps[peak];
+        while (right + 1 < m && braking[right + 1] <= rising[right + 1] && braking[right + 1] < braking[right]) {
+            length += steps[right++];
+        }
+        // Stretches do not overlap, which keeps this linear.
+        peak = right - 1;
+        if (!kink) {
+            continue;
+        }
+        // The sampled ramps take a little longer than the continuous ones.
+        double from = rising[left];
+        double to = braking[right];
+        auto fits = [&](double level) {
+            return ramp_distance(from, level, max_accel, jerk) + ramp_distance(to, level, max_accel, jerk) <=
+                   0.9 * length;
+        };
+        // Both ramps are monotonic in the speed they climb to.
+        double low = std::max(from, to);
+        double top = high;
+        if (fits(top)) {
+            low = top;
+        }
+        for (int i = 0; i < 30 && low < top; ++i) {
+            double mid = (low + top) / 2.0;
+            (fits(mid) ? low : top) = mid;
+        }
+        for (size_t i = left + 1; i < right; ++i) {
+            if (caps[i] > low) {
+                caps[i] = low;
+                lowered = true;
+            }
+        }
+    }
+    return lowered;
+}
+
+// An envelope only sees a corner's cap at the corner itself, so it can run
+// into one still speeding up and drop its acceleration in a single step,
+// either easing on the last step before the corner or clamped at it. Where
+// it sets the profile, holds that cap for as far before the corner as the
+// acceleration takes to ramp down, so the next pass eases into it.
+// Returns whether any cap was lowered.
+bool hold_caps(const std::vector<double>& speeds, const std::vector<double>& other, const std::vector<double>& steps,
+               const VelocityLimits& limits, bool from_end, std::vector<double>& caps) {
+    size_t m = caps.size();
+    double jerk = limits.max_jerk_m_s3;
+    // Point k steps from the envelope's start, and the step leading to it.
+    auto at = [&](size_t k) { return from_end ? m - 1 - k : k; };
+    auto step = [&](size_t k) { return steps[from_end ? m - 1 - k : k - 1]; };
+    auto accel = [&](size_t k) {
+        double v0 = speeds[at(k - 1)], v1 = speeds[at(k)];
+        return (v1 * v1 - v0 * v0) / (2.0 * step(k));
+    };
+    auto duration = [&](size_t k) {
+        double v0 = speeds[at(k - 1)], v1 = speeds[at(k)];
+        return v0 + v1 > 0.0 ? 2.0 * step(k) / (v0 + v1) : 0.0;
+    };
+    bool lowered = false;
+    for (size_t k = 2; k < m; ++k) {
+        size_t mid = at(k - 1);
+        if (other[mid] < speeds[mid] || other[at(k - 2)] < speeds[at(k - 2)]) {
+            continue;
+        }
+        double before = accel(k - 1);
+        if (before <= 0.0 || before - accel(k) <= jerk * (duration(k - 1) + duration(k)) / 2.0) {
+            continue;
+        }
+        size_t corner = k - 1;
+        if (caps[at(k)] < caps[mid]) {
+            corner = k;
+        } else if (caps[mid] >= caps[at(k - 2)]) {
+            continue;
+        }
+        double level = caps[at(corner)];
+        double hold = speeds[mid] * before / jerk;
+        for (size_t back = corner; back > 0 && hold > 0.0; --back) {
+            if (caps[at(back - 1)] > level) {
+                caps[at(back - 1)] = level;
+                lowered = true;
+            }
+            hold -= step(back);
+        }
+    }
+    return lowered;
+}
+
+}
+
+VelocityProfile plan_velocity_profile(const std::vector<NedPoint>& path, const VelocityLimits& limits) {
+    VelocityProfile profile;
+    // Vertices without repeats, then caps from their turn angles.
+    std::vector<NedPoint> vertices;
+    vertices.reserve(path.size());
+    for (const auto& point : path) {
+        if (vertices.empty() || distance(vertices.back(), point) > 1e-9) {
+            vertices.push_back(point);
+        }
+    }
+    if (vertices.empty()) {
+        return profile;
+    }
+    size_t n = vertices.size();
+    std::vector<double> legs(n - 1);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        legs[i] = distance(vertices[i], vertices[i + 1]);
+    }
+
+    // Resample long legs; points inside a leg are capped only by max speed.
+    std::vector<double> caps;
+    std::vector<double> steps;  // steps[i]: distance from point i to i + 1
+    profile.points.reserve(n);
+    caps.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        double cap = 0.0;
+        if (i > 0 && i + 1 < n) {
+            cap = corner_speed(vertices[i - 1], vertices[i], vertices[i + 1], legs[i - 1], legs[i], limits);
+        }
+        profile.points.push_back(vertices[i]);
+        caps.push_back(cap);
+        if (i + 1 == n) {
+            break;
+        }
+        size_t count = std::max<size_t>(1, static_cast<size_t>(std::ceil(legs[i] / limits.max_step_m)));
+        const NedPoint& a = vertices[i];
+        const NedPoint& b = vertices[i + 1];
+        for (size_t k = 1; k < count; ++k) {
+            double f = static_cast<double>(k) / count;
+            profile.points.push_back({a.north_m + (b.north_m - a.north_m) * f, a.east_m + (b.east_m - a.east_m) * f,
+                                      a.down_m + (b.down_m - a.down_m) * f});
+            caps.push_back(limits.max_speed_m_s);
+        }
+        for (size_t k = 0; k < count; ++k) {
+            steps.push_back(legs[i] / count);
+        }
+    }
+    // Speed up from the start and brake for the end; the profile is the
+    // lower of the two. Lowering caps where either turns too sharply can
+    // move a peak under a cap it used to be clamped to and on into the next
+    // stretch, so that takes a few rounds.
+    std::vector<double> rising = envelope(caps, steps, limits, false);
+    std::vector<double> braking = envelope(caps, steps, limits, true);
+    for (int round = 0; round < kLevelRounds; ++round) {
+        bool lowered = level_peaks(rising, braking, steps, limits, caps);
+        lowered = hold_caps(rising, braking, steps, limits, false, caps) || lowered;
+        lowered = hold_caps(braking, rising, steps, limits, true, caps) || lowered;
+        if (!lowered) {
+            break;
+        }
+        rising = envelope(caps, steps, limits, false);
+        braking = envelope(caps, steps, limits, true);
+    }
+    size_t m = profile.points.size();
+    profile.speeds.resize(m);
+    profile.times.resize(m);
+    profile.speeds[0] = 0.0;
+    profile.times[0] = 0.0;
+    for (size_t i = 0; i + 1 < m; ++i) {
+        double v = profile.speeds[i];
+        double speed = std::min(rising[i + 1], braking[i + 1]);
+        double d = steps[i];
+        profile.speeds[i + 1] = speed;
+        double dt = v + speed > 0.0 ? 2.0 * d / (v + speed) : 2.0 * std::sqrt(d / limits.max_accel_m_s2);
+        profile.times[i + 1] = profile.times[i] + dt;
+    }
+    return profile;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Speed profile along a path for setpoint streaming: as fast as the limits
+// allow, slowing for corners and stopping at both ends.
+
+// Point or vector in the autopilot's local NED frame, in metres (or m/s).
+struct NedPoint {
+    double north_m = 0.0;
+    double east_m = 0.0;
+    double down_m = 0.0;
+};
+
+struct VelocityLimits {
+    double max_speed_m_s = 5.0;
+    double max_accel_m_s2 = 2.0;          // along the path
+    double max_jerk_m_s3 = 4.0;           // rate of change of that acceleration
+    double max_lateral_accel_m_s2 = 2.0;  // in corners
+    double corner_radius_m = 0.5;         // how far from a vertex its corner is rounded
+    double max_step_m = 0.25;             // longer legs are resampled
+};
+
+struct VelocityProfile {
+    std::vector<NedPoint> points;
+    std::vector<double> speeds;  // m/s at each point
+    std::vector<double> times;   // arrival time at each point
+
+    double duration_s() const { return times.empty() ? 0.0 : times.back(); }
+};
+
+// Plans a profile in O(n) for n resampled points. Each vertex gets a speed
+// cap from its turn angle, as if the corner were rounded over
+// corner_radius_m (less on short legs), so a finely sampled curve is capped
+// by its actual curvature. A forward pass finds the fastest each point can
+// be reached at and a backward pass the fastest it can still brake from,
+// both ramping the acceleration with the jerk limit and easing into caps;
+// the profile is the lower of the two. Where they meet too sharply, or one
+// runs into a corner still accelerating, the caps there are lowered so the
+// passes ease in, and the passes run again, a bounded number of times. It
+// approximates the time-optimal jerk-limited profile, which has no
+// linear-time solution. Repeated points are dropped.
+VelocityProfile plan_velocity_profile(const std::vector<NedPoint>& path, const VelocityLimits& limits = VelocityLimits{});
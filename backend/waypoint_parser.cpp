@@ -0,0 +1,140 @@
+#include "waypoint_parser.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include "logger.h"
+
+namespace {
+
+// strtod/strtof with std::stod's contract: leading whitespace and trailing
+// garbage are accepted, no digits or an out-of-range value are errors.
+template <typename T, typename Parse>
+const char* parse_number(const char* field, Parse parse, T& value) {
+    char* end = nullptr;
+    errno = 0;
+    value = parse(field, &end);
+    if (end == field) {
+        return "invalid number";
+    }
+    if (errno == ERANGE) {
+        return "number out of range";
+    }
+    return nullptr;
+}
+
+// Fourth field: `on`, `off` or a non-negative flow scale, up to the next
+// comma or the end of the line. An empty field leaves `present` false.
+const char* parse_flow(const char* field, const char* end, float& flow, bool& present) {
+    while (field < end && (*field == ' ' || *field == '\t')) {
+        ++field;
+    }
+    const char* stop = static_cast<const char*>(std::memchr(field, ',', end - field));
+    size_t length = (stop ? stop : end) - field;
+    while (length && (field[length - 1] == ' ' || field[length - 1] == '\t' || field[length - 1] == '\r')) {
+        --length;
+    }
+    present = length > 0;
+    if (!present) {
+        return nullptr;
+    }
+    if (length == 2 && std::strncmp(field, "on", 2) == 0) {
+        flow = 1.0f;
+        return nullptr;
+    }
+    if (length == 3 && std::strncmp(field, "off", 3) == 0) {
+        flow = 0.0f;
+        return nullptr;
+    }
+    const char* error = parse_number(field, std::strtof, flow);
+    if (!error && !(flow >= 0.0f)) {
+        error = "negative flow";
+    }
+    return error;
+}
+
+}
+
+void WaypointParser::feed(const char* data, size_t size) {
+    bytes_ += size;
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* line_end = newline ? newline : end;
+        if (!overlong_) {
+            if (partial_.size() + (line_end - data) > max_line_) {
+                overlong_ = true;
+                partial_.clear();
+            } else {
+                partial_.append(data, line_end);
+            }
+        }
+        if (!newline) {
+            return;
+        }
+        if (overlong_) {
+            ++invalid_lines_;
+            log_warn("waypoints.line_too_long").field("max_bytes", max_line_);
+        } else {
+            parse_line(partial_.data(), partial_.data() + partial_.size());
+        }
+        partial_.clear();
+        overlong_ = false;
+        data = newline + 1;
+    }
+}
+
+void WaypointParser::finish() {
+    if (!partial_.empty() && !overlong_) {
+        parse_line(partial_.data(), partial_.data() + partial_.size());
+    }
+    partial_.clear();
+    overlong_ = false;
+}
+
+void WaypointParser::parse_line(const char* begin, const char* end) {
+    // `partial_` holds the line, so fields are NUL-terminated at `end`.
+    const char* lon = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+    if (!lon) {
+        return;
+    }
+    const char* alt = static_cast<const char*>(std::memchr(lon + 1, ',', end - lon - 1));
+    if (!alt || alt + 1 == end) {
+        return;
+    }
+    double lat_deg = 0.0;
+    double lon_deg = 0.0;
+    float alt_m = 0.0f;
+    const char* error = parse_number(begin, std::strtod, lat_deg);
+    if (!error) {
+        error = parse_number(lon + 1, std::strtod, lon_deg);
+    }
+    if (!error) {
+        error = parse_number(alt + 1, std::strtof, alt_m);
+    }
+    const char* flow_field = static_cast<const char*>(std::memchr(alt + 1, ',', end - alt - 1));
+    float flow = flow_;
+    bool has_flow = false;
+    if (!error && flow_field) {
+        error = parse_flow(flow_field + 1, end, flow, has_flow);
+    }
+    if (error) {
+        ++invalid_lines_;
+        log_warn("waypoints.invalid_line").field("line", std::string(begin, end)).field("error", error);
+        return;
+    }
+    mavsdk::Mission::MissionItem item{};
+    item.latitude_deg = lat_deg;
+    item.longitude_deg = lon_deg;
+    item.relative_altitude_m = alt_m;
+    item.is_fly_through = false;
+    items_.push_back(item);
+    if (has_flow && flows_.empty()) {
+        // First flow field: earlier items had none, so they dispense nothing.
+        flows_.resize(items_.size() - 1, 0.0f);
+    }
+    if (!flows_.empty()) {
+        flows_.push_back(flow);
+    }
+    flow_ = flow;
+}
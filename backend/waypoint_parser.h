@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <mavsdk/plugins/mission/mission.h>
+
+// Incremental parser for the `latitude,longitude,relative_altitude_m[,flow]`
+// CSV mission format. feed() takes the body in whatever chunks the network
+// delivers, so /start parses while the upload is still arriving and only the
+// current partial line is ever buffered. Lines with fewer than three fields
+// are skipped; lines whose numbers do not parse are logged and skipped.
+//
+// The optional fourth field is the foam flow on the leg that ends at that
+// waypoint: `on` (1), `off` (0) or a scale of the configured bead. A line
+// without it keeps the previous line's flow.
+class WaypointParser {
+public:
+    // Lines longer than `max_line` bytes are dropped rather than buffered.
+    explicit WaypointParser(size_t max_line = 4096) : max_line_(max_line) {}
+
+    void feed(const char* data, size_t size);
+    // Parses a final line that has no trailing newline.
+    void finish();
+
+    std::vector<mavsdk::Mission::MissionItem>& items() { return items_; }
+    // Flow for each item, indexed like items(); empty if no line has a
+    // fourth field, which leaves the dispenser alone.
+    std::vector<float>& flows() { return flows_; }
+    size_t bytes() const { return bytes_; }
+    size_t invalid_lines() const { return invalid_lines_; }
+
+private:
+    void parse_line(const char* begin, const char* end);
+
+    size_t max_line_;
+    std::string partial_;
+    bool overlong_ = false;
+    size_t bytes_ = 0;
+    size_t invalid_lines_ = 0;
+    std::vector<mavsdk::Mission::MissionItem> items_;
+    std::vector<float> flows_;
+    float flow_ = 0.0f;
+};
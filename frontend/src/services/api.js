@@ -1,6 +1,11 @@
 import axios from 'axios';
 
 const API_URL = 'http://localhost:8080';
+// Telemetry polls go to the backend's event-loop port so they never hold one
+// of the main listener's workers; safety commands have a listener of their own.
+const TELEMETRY_URL = 'http://localhost:8081';
+const SAFETY_URL = 'http://localhost:8082';
+const SAFETY_COMMANDS = ['abort', 'pause'];
 
 export const sendCommand = (command, data = null) => {
   if (command === 'start' && data) {
@@ -8,25 +13,26 @@ export const sendCommand = (command, data = null) => {
       headers: { 'Content-Type': 'text/plain' },
     });
   }
-  return axios.get(`${API_URL}/${command}`);
+  const base = SAFETY_COMMANDS.includes(command) ? SAFETY_URL : API_URL;
+  return axios.get(`${base}/${command}`);
 };
 
 export const getTelemetry = () => {
-  return axios.get(`${API_URL}/telemetry`);
+  return axios.get(`${TELEMETRY_URL}/telemetry`);
 };
 
 export const getMissionProgress = () => {
-  return axios.get(`${API_URL}/mission_progress`);
+  return axios.get(`${TELEMETRY_URL}/mission_progress`);
 };
 
 export const getBattery = () => {
-  return axios.get(`${API_URL}/battery`);
+  return axios.get(`${TELEMETRY_URL}/battery`);
 };
 
 export const getAltitude = () => {
-    return axios.get(`${API_URL}/altitude`);
+    return axios.get(`${TELEMETRY_URL}/altitude`);
 };
 
 export const getHeading = () => {
-    return axios.get(`${API_URL}/heading`);
-};
\ No newline at end of file
+    return axios.get(`${TELEMETRY_URL}/heading`);
+};